@@ -25,23 +25,78 @@ extern "C" {
 // It is a safe default, but double check it if your system architecture is unusual.
 #endif
 
-// Can be defined as 1 or 2.
+// Number of values in a chunk of an array
+// Arrays hold their values' descriptors, which are twice the size of a pointer, so a chunk takes as much memory as a cha chunk.
+#define LSML_ARRAY_CHUNK_LEN (LSML_CHUNK_LEN/2)
+
+// Load factor of the sections hashmap, can be defined as 1 or 2.
 // If not defined as 1 or 2, the implementation will use a load factor of 0.8
+// Tables and the strings pool are open addressing hashmaps, which always use a load factor of 7/8.
 // #define LSML_LOAD_FACTOR 1
 
+#ifndef LSML_READ_BLOCK_LEN
+// Size of the parser's internal read buffer, in bytes.
+// Readers which fill blocks (instead of lending them) write into this buffer,
+// and single-byte readers are batched into it.
+#define LSML_READ_BLOCK_LEN 4096
+#endif
+
+#ifndef LSML_MEASURE_SCRATCH_LEN
+// Size of the scratch memory used by lsml_parse_measure to parse section names, in bytes.
+// Longer section names are measured by their length in the input instead.
+#define LSML_MEASURE_SCRATCH_LEN 4096
+#endif
+
+#ifndef LSML_MAX_THREADS
+// Maximum number of threads used by lsml_parse_parallel.
+#define LSML_MAX_THREADS 64
+#endif
+
+// Define this to use threads in lsml_parse_parallel, requires pthreads or Win32 threads.
+// Without threads, lsml_parse_parallel parses each part of the input one after another.
+// #define LSML_THREADS
+
+// Define this to disable SSE2/AVX2 scanning of strings during parsing,
+// leaving only the portable word-at-a-time scanner, and SSE2 matching of control bytes in tables and the strings pool.
+// #define LSML_NO_SIMD
+
 
 // --- Invariants and Conventions
 //
 // - All allocations are done through the bump allocator
-// - Any pointer returned by a lsml function will never be invalidated (no use-after-free possible)
+// - Any pointer returned by a lsml function will never be invalidated (no use-after-free possible), except:
+//   - The string of a value of an array storing values on its own (see lsml_array_set_interning) is reused
+//     once lsml_array_set replaces it or lsml_array_remove_row removes its row
+//   - Compacting a data in place (see lsml_data_compact_in_place) invalidates every pointer into it but the data itself
 // - Read only operations on an LSML data should be able to succeed even after running out of memory
 // - All lsml_reg_str_t are unique, and pointers to them are unique
 // - All lsml_string_t retrieved from lsml_data are null-terminated
 //   - Strings passed in by the user are not necessarily null-terminated
+//   - Strings parsed in place are owned by the user's buffer, not the bump allocator
 
 
 // --- Macros
 
+// x86 SIMD support for scanning strings.
+// SSE2 is always available on x86-64, AVX2 is detected at runtime with GCC or Clang.
+#if !defined(LSML_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define LSML_SSE2
+    #include <emmintrin.h>
+    #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        #define LSML_AVX2
+        #include <immintrin.h>
+    #endif
+#endif
+
+#ifdef LSML_THREADS
+    #if defined(_WIN32) || defined(_WIN64)
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+    #else
+        #include <pthread.h>
+    #endif
+#endif
+
 // I just want to know the alignment... :(
 // First: check common compiler-specific extensions
 // Second: check if C/C++ version supports alignof officially
@@ -71,16 +126,30 @@ typedef union{size_t s;void *p;} lsml_max_align_t;
 
 // --- Types
 
+// Header at the start of each block of a growable data
+typedef struct lsml_block_t {
+    struct lsml_block_t *prev; // NULL for the first block
+    size_t size; // including this header
+} lsml_block_t;
+
 typedef struct lsml_bump_alloc_t {
     char * mem;
     size_t offset;
     size_t size;
+    // growable datas chain new blocks from the allocator when the current block is full
+    lsml_block_t *block; // header of the current block, NULL if the memory is fixed
+    size_t used; // bytes used by previous blocks
+    lsml_allocator_t allocator;
+    void **free_lists; // heads of the free lists (see lsml_bump_free), NULL until a block is first given back
 } lsml_bump_alloc_t;
 
+// Hash of a string, seeded per data (see lsml_hash_string)
+typedef uint64_t lsml_hash_t;
+
 // Registered string (stores hash)
 typedef struct lsml_reg_str_t {
     lsml_string_t string;
-    lsml_index_t hash;
+    lsml_hash_t hash;
 } lsml_reg_str_t;
 
 // Common header of entries inside a hashmap
@@ -97,42 +166,123 @@ typedef struct lsml_cha_chunk_t {
 } lsml_cha_chunk_t;
 
 
+// Chunk of an array, which holds its values' descriptors rather than pointers to them, so it isn't a cha chunk
 typedef struct lsml_array_chunk_t {
     struct lsml_array_chunk_t *next;
-    lsml_string_t *elems[LSML_CHUNK_LEN];
+    lsml_string_t elems[LSML_ARRAY_CHUNK_LEN];
 } lsml_array_chunk_t;
 
-typedef struct lsml_rows_index_t {
-    struct lsml_rows_index_t *next;
-    size_t index;
-} lsml_rows_index_t;
-
-
-typedef struct lsml_table_node_t {
-    lsml_hm_node_t node;
-    lsml_string_t *value;
-} lsml_table_node_t;
 
-typedef struct lsml_table_chunk_t {
-    struct lsml_table_chunk_t *next;
-    lsml_table_node_t *buckets[LSML_CHUNK_LEN];
-} lsml_table_chunk_t;
+// Open addressing hashmap ("oa"), with a control byte for each slot
+// Slots are grouped by LSML_OA_GROUP_LEN, and each full slot's control byte holds 7 bits of its hash,
+// so a whole group is checked for a key at once before any entry is read.
+typedef struct lsml_oa_t {
+    unsigned char *ctrl; // LSML_OA_EMPTY, or the low 7 bits of the hash of the entry in the slot
+    void *slots; // entries, all starting with lsml_oa_entry_t
+    // slots of the entries in the order they were added, NULL if the hashmap keeps no order
+    // Its capacity is the most entries the load factor allows.
+    uint32_t *order;
+    size_t cap; // number of slots, 0 or LSML_OA_GROUP_LEN times a power of 2
+    // slots of removed entries, which are marked as deleted and stay in the order until the hashmap is rebuilt
+    size_t n_deleted;
+} lsml_oa_t;
+
+// Common header of entries inside an open addressing hashmap
+// The hash is stored next to the key, so probing compares hashes without following the key pointer.
+typedef struct lsml_oa_entry_t {
+    lsml_hash_t hash;
+    lsml_reg_str_t *str;
+} lsml_oa_entry_t;
+
+// The value's descriptor is stored in the entry, so reading it doesn't follow a pointer to its registered string.
+typedef struct lsml_table_entry_t {
+    lsml_oa_entry_t entry;
+    lsml_string_t value;
+} lsml_table_entry_t;
+
+// Minimal perfect hash ("mph") of a fixed set of keys, which maps n keys to n distinct indices
+// Each key's hash picks a bucket, and the bucket's pilot picks the key's index (see lsml_mph_index).
+typedef struct lsml_mph_t {
+    uint32_t *pilots;
+    size_t n_buckets; // 0 if there are no keys
+} lsml_mph_t;
+
+// String of a frozen data, by the offset of its bytes from the data, which are followed by a null terminator
+typedef struct lsml_frozen_str_t {
+    uint32_t off;
+    uint32_t len;
+} lsml_frozen_str_t;
+
+// Entry of a frozen table, in the slot given by the minimal perfect hash of its key
+typedef struct lsml_frozen_entry_t {
+    lsml_hash_t hash;
+    lsml_frozen_str_t key;
+    lsml_frozen_str_t value;
+} lsml_frozen_entry_t;
+
+// Section of a frozen data, which finds the rest of the data by offsets from the data, like the data itself
+// Its node lines up with the node of other sections, and has no string, which tells the two kinds apart.
+typedef struct lsml_frozen_section_t {
+    lsml_hm_node_t node; // always zeroed
+    lsml_hash_t name_hash;
+    lsml_frozen_str_t name;
+    uint32_t self; // offset of the section itself, which finds the data from it
+    uint32_t next_added; // next section in the order they were added, 0 for the last
+    uint32_t n_elems;
+    uint32_t is_array;
+    // a table's lsml_frozen_entry_t, or an array's lsml_frozen_str_t, one after another
+    uint32_t elems;
+    // a table's slots in the order its entries were added, or the index of the first value of each row of an array
+    uint32_t order;
+    // pilots of the minimal perfect hash of a table's keys
+    uint32_t pilots;
+    uint32_t n_buckets;
+    // the rows of an array, as in lsml_section_t, except that min_cols is UINT32_MAX when it would be SIZE_MAX
+    uint32_t n_rows;
+    uint32_t min_cols;
+    uint32_t max_cols;
+    uint32_t uninterned;
+    // counts of values added to an array, which may pass the 32 bits of everything else, since replaced values count
+    uint64_t n_interned;
+    uint64_t n_reused;
+} lsml_frozen_section_t;
 
 
 struct lsml_section_t {
     lsml_hm_node_t node;
     union {
-        lsml_table_chunk_t *table;
+        lsml_oa_t table;
         lsml_array_chunk_t *array;
     } section;
-    union {
-        lsml_table_chunk_t *table;
-        lsml_array_chunk_t *array;
-    } last_chunk;
+    struct lsml_section_t *next_added; // next section in the order they were added
+    lsml_array_chunk_t *last_chunk; // last chunk of an array
+    // directory of an array's chunks, NULL while it has one chunk
+    // Its capacity is n_chunks rounded up to a power of 2, and it moves to one twice as large when full.
+    lsml_array_chunk_t **array_dir;
     size_t n_elems;
-    size_t n_chunks;
-    lsml_rows_index_t *row_indices; // If NULL, then this section is a table, otherwise it is an array.
-    lsml_rows_index_t *last_row_index;
+    size_t n_chunks; // chunks of an array
+    // index of the first element of each row of an array
+    // If NULL, then this section is a table, otherwise it is an array.
+    // Its capacity is n_rows rounded up to a power of 2, and it moves to one twice as large when full.
+    size_t *row_starts;
+    size_t n_rows; // an array always has at least one row, which may be empty
+    // fewest and most columns in the rows of an array before its last row, which may still grow
+    size_t min_cols;
+    size_t max_cols;
+    // number of rows of each width before the last row, so removing a row finds the next fewest or most columns
+    // NULL until a row is first removed (see lsml_array_remove_row). Its capacity is a power of 2 above max_cols.
+    size_t *width_rows;
+    size_t width_cap;
+    // if an array stores its values on their own, instead of interning them with the data's strings
+    int uninterned;
+    // values added to an array while it interned them, and how many of those the data already had
+    size_t n_interned;
+    size_t n_reused;
+    lsml_hash_t hash_seed; // copy of the data's seed, to hash keys given to lsml_table_get
+    // Body of a section which is not parsed yet (see lsml_parse_lazy), NULL once it is parsed
+    const char *lazy_body;
+    size_t lazy_len;
+    lsml_index_t lazy_line;
 };
 
 
@@ -141,11 +291,6 @@ typedef struct lsml_section_chunk_t {
     lsml_section_t *buckets[LSML_CHUNK_LEN];
 } lsml_section_chunk_t;
 
-typedef struct lsml_strings_chunk_t {
-    struct lsml_strings_chunk_t *next;
-    lsml_hm_node_t *buckets[LSML_CHUNK_LEN];
-} lsml_strings_chunk_t;
-
 
 struct lsml_data_t {
     // bump allocator
@@ -154,27 +299,115 @@ struct lsml_data_t {
     // section hashmap chunks
     lsml_section_chunk_t *sections_head;
     lsml_section_chunk_t *sections_tail;
+    lsml_section_chunk_t **sections_dir; // NULL while there is one chunk
     size_t n_sections;
     size_t n_section_chunks;
+    // sections in the order they were added, linked by next_added
+    lsml_section_t *first_added;
+    lsml_section_t *last_added;
 
-    // strings hashmap chunks
-    lsml_strings_chunk_t *strings_head;
-    lsml_strings_chunk_t *strings_tail;
+    // strings hashmap, with lsml_oa_entry_t entries
+    lsml_oa_t strings;
     size_t n_strings;
-    size_t n_strings_chunks;
+
+    // seed of every hash in the data (see lsml_data_set_seed)
+    lsml_hash_t hash_seed;
+
+    // if the data was made by lsml_data_freeze, and has no strings hashmap
+    int frozen;
+    // A frozen data holds no pointers, so its memory reads the same at any address: the data starts it,
+    // and finds everything else there by offsets from itself, 0 meaning nothing.
+    // Its sections (lsml_frozen_section_t) are in the order given by the minimal perfect hash of their names,
+    // instead of the sections hashmap, and are still linked in the order they were added, from frozen_first.
+    uint32_t frozen_sections;
+    uint32_t frozen_pilots;
+    uint32_t frozen_n_buckets;
+    uint32_t frozen_first;
+    // descriptors of the strings of a frozen data (lsml_frozen_str_t), n_strings of them
+    uint32_t frozen_strings;
+
+    // logs errors of sections parsed lazily (see lsml_parse_lazy)
+    lsml_parse_err_log_fn err_log;
+    void *err_log_userdata;
 };
 
 
+static void *lsml_default_alloc(void *userdata, size_t size) {
+    (void) userdata;
+    return malloc(size);
+}
+
+static void lsml_default_free(void *userdata, void *ptr, size_t size) {
+    (void) userdata;
+    (void) size;
+    free(ptr);
+}
+
+// Chains a new block with room for at least `size` bytes, twice as large as the current block.
+// Returns nonzero if the memory is fixed or the allocator fails.
+static int lsml_bump_grow(lsml_bump_alloc_t *alloc, size_t size) {
+    if (alloc->block == NULL) return 1;
+    size_t block_size = alloc->size*2;
+    size_t min_size = sizeof(lsml_block_t) + size + sizeof(lsml_max_align_t) + 1;
+    if (min_size < size) return 1; // overflow
+    if (block_size < min_size) block_size = min_size;
+    lsml_block_t *block = (lsml_block_t *) alloc->allocator.alloc(alloc->allocator.userdata, block_size);
+    if (block == NULL) return 1;
+    block->prev = alloc->block;
+    block->size = block_size;
+    alloc->used += alloc->offset;
+    alloc->block = block;
+    alloc->mem = (char *) block;
+    alloc->offset = sizeof(lsml_block_t);
+    alloc->size = block_size;
+    return 0;
+}
+
 static void *lsml_bump_alloc(lsml_bump_alloc_t *alloc, size_t size, size_t align) {
     size_t aligned_offset = (alloc->offset + (align-1)) & ~(align-1);
-    if (aligned_offset + size >= alloc->size) return NULL;
+    if (aligned_offset + size >= alloc->size) {
+        if (lsml_bump_grow(alloc, size)) return NULL;
+        aligned_offset = (alloc->offset + (align-1)) & ~(align-1);
+    }
     void *ptr = alloc->mem + aligned_offset;
     alloc->offset = aligned_offset + size;
     return ptr;
 }
 
+// Undoes allocations made since the allocator was at `offset` in the block at `mem`.
+// If a growable data has moved on to another block since, they are kept until the data is freed.
+static void lsml_bump_rewind(lsml_bump_alloc_t *alloc, const char *mem, size_t offset) {
+    if (alloc->mem == mem) alloc->offset = offset;
+}
+
+// Takes `size` bytes of temporary memory, from the allocator of growable memory, or from the end of fixed memory,
+// which is then kept from allocations until it is given back. Returns NULL if there is no memory for it.
+// Like allocations, the end of fixed memory is aligned relative to its start.
+static void *lsml_bump_take_scratch(lsml_bump_alloc_t *alloc, size_t size, size_t align, size_t *og_size) {
+    if (alloc->block) return alloc->allocator.alloc(alloc->allocator.userdata, size);
+    if (alloc->size - alloc->offset <= size + align) return NULL;
+    *og_size = alloc->size;
+    alloc->size = (alloc->size - size) & ~(align-1);
+    return alloc->mem + alloc->size;
+}
+
+// Gives back memory taken by lsml_bump_take_scratch, which must be the last taken, where fixed memory was `og_size` bytes before.
+static void lsml_bump_give_back_scratch(lsml_bump_alloc_t *alloc, void *scratch, size_t size, size_t og_size) {
+    if (alloc->block == NULL) alloc->size = og_size;
+    else if (alloc->allocator.free) alloc->allocator.free(alloc->allocator.userdata, scratch, size);
+}
+
+// If the pointer is in the block currently being allocated from.
+static inline int lsml_bump_owns_ptr(const lsml_bump_alloc_t *alloc, const void *ptr) {
+    return (const char*)ptr >= alloc->mem && (const char*)ptr < alloc->mem+alloc->size;
+}
+
 static inline int lsml_data_owns_ptr(lsml_data_t *data, const void *ptr) {
-    return (const char*)ptr >= data->alloc.mem && (const char*)ptr < data->alloc.mem+data->alloc.size;
+    if (lsml_bump_owns_ptr(&data->alloc, ptr)) return 1;
+    for (lsml_block_t *block = data->alloc.block ? data->alloc.block->prev : NULL; block; block = block->prev) {
+        if ((const char*)ptr >= (const char*)block && (const char*)ptr < (const char*)block + block->size) return 1;
+    }
+    return 0;
 }
 
 const char *lsml_strerr(lsml_err_t err) {
@@ -232,43 +465,102 @@ static int lsml_string_eq(const lsml_string_t *a, const lsml_string_t *b) {
 
 // --- Chunked Array
 
-// Gets the element at `index` in a chunked array.
-// If NULL, the element either does not exist, or is not assigned a value (since all cha implementations are assumed to store pointers).
-static void * lsml_cha_get(void *header, size_t n_elems, size_t n_chunks, size_t index) {
-    lsml_cha_chunk_t *cha = (lsml_cha_chunk_t *)header;
-    if (cha == NULL || index >= n_elems || index >= n_chunks*LSML_CHUNK_LEN) return NULL;
-    for (; index >= LSML_CHUNK_LEN; index -= LSML_CHUNK_LEN) {
-        cha = cha->next;
-        if (cha == NULL) return NULL;
-    }
-    return cha->elems[index];
-}
-
 // Gets the pointer to element at `index` in a chunked array within the array's full capacity.
 // This is used primarily with hashmaps, since hashmap n_elements is independent of array length.
+// `dir` is the directory of the array's chunks, which hashmaps only have once they have more than one chunk,
+// so any bucket is found in constant time.
 // If the pointer to element is NULL, then the index is out of bounds of the capacity.
 // If the element itself is NULL, it is not assigned a value (since all cha implementations are assumed to store pointers).
-static void ** lsml_cha_get_bucket(void *header, size_t n_chunks, size_t index) {
-    lsml_cha_chunk_t *cha = (lsml_cha_chunk_t *)header;
-    if (cha == NULL || index >= n_chunks*LSML_CHUNK_LEN) return NULL;
-    while(index >= LSML_CHUNK_LEN) {
-        cha = cha->next;
-        if (cha == NULL) return NULL;
-        index -= LSML_CHUNK_LEN;
-    }
-    return cha->elems + index;
+static void ** lsml_cha_get_bucket(void *header, void **dir, size_t n_chunks, size_t index) {
+    if (header == NULL || index >= n_chunks*LSML_CHUNK_LEN) return NULL;
+    lsml_cha_chunk_t *cha = dir ? (lsml_cha_chunk_t *) dir[index / LSML_CHUNK_LEN] : (lsml_cha_chunk_t *)header;
+    return cha->elems + (index % LSML_CHUNK_LEN);
 }
 
 
 // --- Hash Map
 
-static lsml_index_t lsml_hash_string(const lsml_string_t *str) {
-    // modified from Lua 5.4, can use better hash later
-    lsml_index_t l = (lsml_index_t)str->len;
-    lsml_index_t h = l; // seed ^ l, but seed=0 b/c no randomness source
-    for (; l > 0; l--)
-        h ^= ((h<<5) + (h>>2) + (unsigned char)(str->str[l - 1]));
-    return h;
+// The hash is wyhash (final version 4, public domain) by Wang Yi, which reads 8 or 16 bytes at a time.
+// Words are read in native byte order, so hashes differ between little- and big-endian systems.
+
+static const uint64_t lsml_wyp[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull};
+
+// Multiplies a and b into 128 bits, storing the low half in a and the high half in b.
+static inline void lsml_wymum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 r = (unsigned __int128) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+    uint64_t rh = ha*hb, rm0 = ha*lb, rm1 = hb*la, rl = la*lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t lsml_wymix(uint64_t a, uint64_t b) {
+    lsml_wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t lsml_wyr8(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t lsml_wyr4(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// Hashes a string with the seed of a data.
+static lsml_hash_t lsml_hash_string(const lsml_string_t *str, lsml_hash_t seed) {
+    const unsigned char *p = (const unsigned char *) str->str;
+    size_t len = str->len;
+    uint64_t a, b;
+    seed ^= lsml_wymix(seed ^ lsml_wyp[0], lsml_wyp[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (lsml_wyr4(p) << 32) | lsml_wyr4(p + ((len >> 3) << 2));
+            b = (lsml_wyr4(p + len - 4) << 32) | lsml_wyr4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = lsml_wymix(lsml_wyr8(p) ^ lsml_wyp[1], lsml_wyr8(p + 8) ^ seed);
+                see1 = lsml_wymix(lsml_wyr8(p + 16) ^ lsml_wyp[2], lsml_wyr8(p + 24) ^ see1);
+                see2 = lsml_wymix(lsml_wyr8(p + 32) ^ lsml_wyp[3], lsml_wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = lsml_wymix(lsml_wyr8(p) ^ lsml_wyp[1], lsml_wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = lsml_wyr8(p + i - 16);
+        b = lsml_wyr8(p + i - 8);
+    }
+    a ^= lsml_wyp[1];
+    b ^= seed;
+    lsml_wymum(&a, &b);
+    return lsml_wymix(a ^ lsml_wyp[0] ^ len, b ^ lsml_wyp[1]);
 }
 
 // Gets the modulo of a % b, where b is a multiple of LSML_CHUNK_LEN.
@@ -283,32 +575,16 @@ static inline size_t lsml_mod_chunklen(size_t a, size_t b) {
 
 // `buckets_cha_header` MUST be a cha_chunk_t* storing a type compatible with `lsml_hm_node_t *`.
 // Returns a pointer compatible with `lsml_hm_node_t *` if found, NULL if not found.
-static void * lsml_hm_get_node(void *buckets_cha_header, size_t n_chunks, lsml_string_t *key) {
-    if (buckets_cha_header == NULL || key == NULL) return NULL;
-    size_t cap = n_chunks*LSML_CHUNK_LEN;
-    size_t index = lsml_mod_chunklen(lsml_hash_string(key), cap);
-    void **addr = lsml_cha_get_bucket(buckets_cha_header, n_chunks, index);
-    if (addr == NULL) return NULL;
-    lsml_hm_node_t *node = (lsml_hm_node_t *) *addr;
-    for (; node != NULL; node = node->next) {
-        if (lsml_string_eq(&node->str->string, key)) {
-            return node;
-        }
-    }
-    return NULL;
-}
-
-// `buckets_cha_header` MUST be a cha_chunk_t* storing a type compatible with `lsml_hm_node_t *`.
-// Returns a pointer compatible with `lsml_hm_node_t *` if found, NULL if not found.
-static void * lsml_hm_get_node_reg(void *buckets_cha_header, size_t n_chunks, lsml_reg_str_t *key) {
+static void * lsml_hm_get_node(void *buckets_cha_header, void **dir, size_t n_chunks, lsml_string_t *key, lsml_hash_t seed) {
     if (buckets_cha_header == NULL || key == NULL) return NULL;
     size_t cap = n_chunks*LSML_CHUNK_LEN;
-    size_t index = lsml_mod_chunklen(lsml_hash_string(&key->string), cap);
-    void **addr = lsml_cha_get_bucket(buckets_cha_header, n_chunks, index);
+    lsml_hash_t hash = lsml_hash_string(key, seed);
+    size_t index = lsml_mod_chunklen((size_t) hash, cap);
+    void **addr = lsml_cha_get_bucket(buckets_cha_header, dir, n_chunks, index);
     if (addr == NULL) return NULL;
     lsml_hm_node_t *node = (lsml_hm_node_t *) *addr;
     for (; node != NULL; node = node->next) {
-        if (node->str == key) { // registered strings are unique, can be compared by pointer
+        if (node->str->hash == hash && lsml_string_eq(&node->str->string, key)) {
             return node;
         }
     }
@@ -318,15 +594,14 @@ static void * lsml_hm_get_node_reg(void *buckets_cha_header, size_t n_chunks, ls
 // Returns new `lsml_hm_node_t *`-compatible object if it is not found in the hashmap and is able to be created.
 // Returns the exitsing node if it is found.
 // If was_created is given, it is set to whether the returned node was found (0) or created (1).
-static void * lsml_hm_get_or_create_node(lsml_bump_alloc_t *alloc, void *buckets_cha_header, size_t *n_elems, size_t n_chunks, lsml_reg_str_t *key, size_t node_size, size_t node_align, int *was_created) {
+static void * lsml_hm_get_or_create_node(lsml_bump_alloc_t *alloc, void *buckets_cha_header, void **dir, size_t *n_elems, size_t n_chunks, lsml_reg_str_t *key, size_t node_size, size_t node_align, int *was_created) {
     // if (key == NULL || key->str == NULL || key->len == 0) return NULL;
     // assert(key);
     // assert(node_size >= sizeof(lsml_hm_node_t));
     // assert(node_align == LSML_ALIGNOF(lsml_hm_node_t));
     size_t cap = n_chunks*LSML_CHUNK_LEN;
-    lsml_index_t hash = key->hash; //lsml_hash_string(&key->string);
-    size_t index = lsml_mod_chunklen(hash, cap);
-    void **bucket_ptr = lsml_cha_get_bucket(buckets_cha_header, n_chunks, index);
+    size_t index = lsml_mod_chunklen((size_t) key->hash, cap);
+    void **bucket_ptr = lsml_cha_get_bucket(buckets_cha_header, dir, n_chunks, index);
     // assert(bucket_ptr != NULL);
     // if (bucket_ptr == NULL) {
     //     // this should never happen...
@@ -360,8 +635,8 @@ static void * lsml_hm_get_or_create_node(lsml_bump_alloc_t *alloc, void *buckets
 // ONLY called during a rehash, puts node in bucket at its index, appended at the end.
 // OVERWRITES next pointer of node to prevent circular references, make sure it is properly unlinked before calling
 // Appends a node to a linked list in an arbitrary chunk position
-static lsml_err_t lsml_hm_put_node_internal(void *buckets_cha_header, size_t n_chunks, lsml_hm_node_t *node, size_t index) {
-    void **bucket_ptr = lsml_cha_get_bucket(buckets_cha_header, n_chunks, index);
+static lsml_err_t lsml_hm_put_node_internal(void *buckets_cha_header, void **dir, size_t n_chunks, lsml_hm_node_t *node, size_t index) {
+    void **bucket_ptr = lsml_cha_get_bucket(buckets_cha_header, dir, n_chunks, index);
     if (bucket_ptr == NULL) return LSML_ERR_NOT_FOUND;
     lsml_hm_node_t *curnode = (lsml_hm_node_t *) *bucket_ptr;
     lsml_hm_node_t *prevnode = NULL;
@@ -379,7 +654,19 @@ static lsml_err_t lsml_hm_put_node_internal(void *buckets_cha_header, size_t n_c
 // If the number of elements in the hashmap exceeds the load factor, then this doubles the number of the hashmap buckets if possible,
 // and shuffles all existing elements into their new bucket
 // TODO: remove chunk size and chunk align args after verification that asserts are never hit, since all chunks should have identical layout
-static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *buckets_cha_head, void **buckets_cha_tail, size_t n_elems, size_t *n_chunks) {
+// Returns if a hashmap with n_elems elements in n_chunks chunks is over its load factor, and needs rehashing.
+static inline int lsml_hm_over_load(size_t n_elems, size_t n_chunks) {
+    size_t cap = n_chunks*LSML_CHUNK_LEN;
+    #if LSML_LOAD_FACTOR == 1
+    return n_elems > cap;
+    #elif LSML_LOAD_FACTOR == 2
+    return n_elems/2 > cap;
+    #else // load factor of 0.8
+    return (n_elems + (n_elems)/4) > cap;
+    #endif
+}
+
+static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *buckets_cha_head, void **buckets_cha_tail, void ***dir, size_t n_elems, size_t *n_chunks) {
     // rehash if over load factor of 0.75
     // count*4/3 > capacity <=> count > 0.75*capacity
     // assert(chunk_size >= sizeof(lsml_cha_chunk_t));
@@ -392,14 +679,12 @@ static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *bucke
     }
     size_t old_n_chunks = *n_chunks;
     size_t old_cap = old_n_chunks*LSML_CHUNK_LEN;
-    #if LSML_LOAD_FACTOR == 1
-    if (n_elems <= old_cap) return LSML_OK;
-    #elif LSML_LOAD_FACTOR == 2
-    if (n_elems/2 <= old_cap) return LSML_OK;
-    #else // load factor of 0.8
-    if ((n_elems + (n_elems)/4) <= old_cap) return LSML_OK;
-    #endif
+    if (!lsml_hm_over_load(n_elems, old_n_chunks)) return LSML_OK;
+    const char *og_mem = alloc->mem;
     size_t og_offset = alloc->offset;
+    // the old directory is abandoned, which wastes less than the new one over all rehashes
+    void **new_dir = (void **) lsml_bump_alloc(alloc, 2*old_n_chunks*sizeof(void *), LSML_ALIGNOF(void *));
+    if (new_dir == NULL) return LSML_ERR_OUT_OF_MEMORY;
     lsml_cha_chunk_t *cha = (lsml_cha_chunk_t *)(*buckets_cha_tail);
     // while(cha->next) {
     //     cha = cha->next;
@@ -409,7 +694,8 @@ static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *bucke
     for (size_t i = 0; i < old_n_chunks; i++) {
         lsml_cha_chunk_t *newcha = (lsml_cha_chunk_t *) lsml_bump_alloc(alloc, sizeof(lsml_cha_chunk_t), LSML_ALIGNOF(lsml_cha_chunk_t));
         if (newcha == NULL) {
-            alloc->offset = og_offset; // free memory
+            old_last_cha->next = NULL; // unlink the new chunks
+            lsml_bump_rewind(alloc, og_mem, og_offset); // free memory
             return LSML_ERR_OUT_OF_MEMORY;
         }
         newcha->next = NULL;
@@ -422,6 +708,12 @@ static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *bucke
 
     size_t new_n_chunks = 2*old_n_chunks;
     size_t new_cap = 2*old_cap;
+    cha = (lsml_cha_chunk_t *)buckets_cha_head;
+    for (size_t i = 0; i < new_n_chunks; i++) {
+        new_dir[i] = cha;
+        cha = cha->next;
+    }
+    *dir = new_dir;
     // time to adjust every single element!!!
     cha = (lsml_cha_chunk_t *)buckets_cha_head; // start from the beginning
     while(cha) {
@@ -444,7 +736,7 @@ static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *bucke
                 } else { // if first in list
                     cha->elems[chunk_index] = (void *) nextnode; // set head to next element
                 }
-                lsml_hm_put_node_internal(buckets_cha_head, new_n_chunks, curnode, newindex);
+                lsml_hm_put_node_internal(buckets_cha_head, new_dir, new_n_chunks, curnode, newindex);
 
                 // because current node was removed, prevnode remains the same
                 curnode = nextnode;
@@ -459,47 +751,528 @@ static lsml_err_t lsml_hm_rehash_if_needed(lsml_bump_alloc_t *alloc, void *bucke
     return LSML_OK;
 }
 
-// ---- Reading Data
+// Gets the index of the lowest set bit, mask must be nonzero.
+static inline unsigned int lsml_ctz(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) __builtin_ctz(mask);
+#else
+    unsigned int i = 0;
+    while (!(mask & 1u)) { mask >>= 1; i++; }
+    return i;
+#endif
+}
 
-lsml_data_t *lsml_data_new(void *buf, size_t size) {
-    lsml_data_t *data;
-    {
-        lsml_bump_alloc_t alloc = {(char*) buf, 0, size};
-        data = (lsml_data_t*) lsml_bump_alloc(&alloc, sizeof(lsml_data_t), LSML_ALIGNOF(lsml_data_t));
-        if (data == NULL) return NULL;
-        data->alloc = alloc;
+// --- Free Lists
+
+// A bump allocator only gives memory back all at once, so blocks which are replaced at runtime are kept in free lists instead:
+// the slots of tables which had entries removed, once the tables are rebuilt, and the bytes of array values stored on their own,
+// once the values are replaced or removed. Each list holds blocks of a range of sizes,
+// and each block starts with the link to the next one, which may not be aligned.
+
+#define LSML_FREE_SLOTS_LISTS 16 // slots of tables with LSML_OA_GROUP_LEN << 0..15 slots
+#define LSML_FREE_STRINGS_LISTS 6 // strings of 16 << 0..5 bytes or more, after the lists of slots
+
+// Gives a block back to a free list. If there is no memory for the heads of the lists, it is abandoned like before.
+static void lsml_bump_free(lsml_bump_alloc_t *alloc, int list, void *block) {
+    if (alloc->free_lists == NULL) {
+        size_t size = (LSML_FREE_SLOTS_LISTS + LSML_FREE_STRINGS_LISTS)*sizeof(void *);
+        alloc->free_lists = (void **) lsml_bump_alloc(alloc, size, LSML_ALIGNOF(void *));
+        if (alloc->free_lists == NULL) return;
+        memset(alloc->free_lists, 0, size);
+    }
+    memcpy(block, &alloc->free_lists[list], sizeof(void *));
+    alloc->free_lists[list] = block;
+}
+
+// Takes a block from a free list, or returns NULL if it is empty.
+static void *lsml_bump_reuse(lsml_bump_alloc_t *alloc, int list) {
+    if (alloc->free_lists == NULL || alloc->free_lists[list] == NULL) return NULL;
+    void *block = alloc->free_lists[list];
+    memcpy(&alloc->free_lists[list], block, sizeof(void *));
+    return block;
+}
+
+// Gets the free list for strings of `size` bytes, the last one whose blocks may be that small, or -1 if they are too small to give back.
+static int lsml_bump_strings_list(size_t size) {
+    int list = -1;
+    for (int i = 0; i < LSML_FREE_STRINGS_LISTS && ((size_t) 16 << i) <= size; i++) list = i;
+    return list;
+}
+
+// Allocates `size` bytes for a string, reusing a block of a string given back by lsml_bump_free_string if one fits.
+// Only the first block of the list for `size` is checked, since blocks in the lists after it always fit.
+static char *lsml_bump_alloc_string(lsml_bump_alloc_t *alloc, size_t size) {
+    int first = lsml_bump_strings_list(size);
+    for (int i = first < 0 ? 0 : first; alloc->free_lists && i < LSML_FREE_STRINGS_LISTS; i++) {
+        char *block = (char *) alloc->free_lists[LSML_FREE_SLOTS_LISTS + i];
+        if (block == NULL) continue;
+        size_t block_size;
+        memcpy(&block_size, block + sizeof(void *), sizeof(size_t));
+        if (block_size >= size) return (char *) lsml_bump_reuse(alloc, LSML_FREE_SLOTS_LISTS + i);
+    }
+    return (char *) lsml_bump_alloc(alloc, size, LSML_ALIGNOF(char));
+}
+
+// Gives back the `size` bytes of a string which is no longer used, storing its size after the link.
+// Strings too small to hold both are abandoned.
+static void lsml_bump_free_string(lsml_bump_alloc_t *alloc, char *str, size_t size) {
+    int list = lsml_bump_strings_list(size);
+    if (list < 0 || size < sizeof(void *) + sizeof(size_t)) return;
+    memcpy(str + sizeof(void *), &size, sizeof(size_t));
+    lsml_bump_free(alloc, LSML_FREE_SLOTS_LISTS + list, str);
+}
+
+// --- Open Addressing Hash Map
+
+// Slots are probed a group at a time, starting from the group picked by the high bits of the hash,
+// then jumping 1, 2, 3, ... groups ahead, which visits every group since the number of groups is a power of 2.
+// A group with an empty slot ends the probe, and the load factor of 7/8 keeps at least one slot empty.
+// Growing allocates new control bytes and slots at twice the capacity, abandoning the old ones,
+// since entries never move once a hashmap has stopped growing, unless entries were removed from it.
+// A hashmap may also keep the order its entries were added in, which is how they are iterated,
+// since the order of the slots depends on the hashes and the capacity.
+// Removing an entry marks its slot as deleted, which doesn't end probes like an empty slot would.
+// Deleted slots count towards the load factor and aren't reused, so the order keeps them until the hashmap is rebuilt.
+
+#define LSML_OA_GROUP_LEN 16
+#define LSML_OA_EMPTY ((unsigned char) 0x80)
+#define LSML_OA_DELETED ((unsigned char) 0xfe)
+
+static inline unsigned char lsml_oa_h2(lsml_hash_t hash) {
+    return (unsigned char) (hash & 0x7f);
+}
+
+static inline size_t lsml_oa_h1(lsml_hash_t hash) {
+    return (size_t) (hash >> 7);
+}
+
+// Gets a mask of the control bytes in a group which equal c.
+static inline uint32_t lsml_oa_match(const unsigned char *group, unsigned char c) {
+#ifdef LSML_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i *) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) c)));
+#else
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < LSML_OA_GROUP_LEN; i++) {
+        if (group[i] == c) mask |= (uint32_t) 1 << i;
+    }
+    return mask;
+#endif
+}
+
+static inline lsml_oa_entry_t *lsml_oa_slot(const lsml_oa_t *oa, size_t entry_size, size_t index) {
+    return (lsml_oa_entry_t *) ((char *) oa->slots + index*entry_size);
+}
+
+// Returns if an open addressing hashmap with n_elems elements is over its load factor, and needs to grow.
+static inline int lsml_oa_over_load(size_t n_elems, size_t cap) {
+    return n_elems*8 > cap*7;
+}
+
+// Gets the most elements an open addressing hashmap holds before it is over its load factor.
+static inline size_t lsml_oa_max_elems(size_t cap) {
+    return cap/8*7;
+}
+
+// Finds the entry with the given hash and key, where entries are `entry_size` bytes and start with lsml_oa_entry_t.
+// If reg_key is given, the key is registered in the same data as the hashmap, so it is compared by pointer.
+// Otherwise, key is compared by its contents.
+// Returns NULL if not found.
+static lsml_oa_entry_t *lsml_oa_find(const lsml_oa_t *oa, size_t entry_size, lsml_hash_t hash, const lsml_string_t *key, const lsml_reg_str_t *reg_key) {
+    if (oa->cap == 0) return NULL;
+    size_t group_mask = oa->cap/LSML_OA_GROUP_LEN - 1;
+    size_t group = lsml_oa_h1(hash) & group_mask;
+    unsigned char h2 = lsml_oa_h2(hash);
+    for (size_t step = 1; ; step++) {
+        const unsigned char *ctrl = oa->ctrl + group*LSML_OA_GROUP_LEN;
+        uint32_t mask = lsml_oa_match(ctrl, h2);
+        while (mask) {
+            lsml_oa_entry_t *entry = lsml_oa_slot(oa, entry_size, group*LSML_OA_GROUP_LEN + lsml_ctz(mask));
+            if (reg_key ? entry->str == reg_key : (entry->hash == hash && lsml_string_eq(&entry->str->string, key))) {
+                return entry;
+            }
+            mask &= mask - 1;
+        }
+        if (lsml_oa_match(ctrl, LSML_OA_EMPTY)) return NULL;
+        group = (group + step) & group_mask;
+    }
+}
+
+// Gets the next entry of an ordered hashmap with n_elems elements, after `*position` entries of its order, or NULL at its end.
+// Removed entries are skipped.
+static lsml_oa_entry_t *lsml_oa_next(const lsml_oa_t *oa, size_t n_elems, size_t entry_size, size_t *position) {
+    while (*position < n_elems + oa->n_deleted) {
+        size_t slot = oa->order[(*position)++];
+        if (oa->n_deleted == 0 || oa->ctrl[slot] != LSML_OA_DELETED) return lsml_oa_slot(oa, entry_size, slot);
+    }
+    return NULL;
+}
+
+// Removes an entry found in the hashmap.
+static void lsml_oa_remove(lsml_oa_t *oa, size_t entry_size, lsml_oa_entry_t *entry) {
+    size_t index = (size_t) ((char *) entry - (char *) oa->slots) / entry_size;
+    oa->ctrl[index] = LSML_OA_DELETED;
+    oa->n_deleted += 1;
+}
+
+// Gets the free list for the slots of an ordered hashmap with given capacity, or -1 if there is none.
+// Ordered hashmaps are tables, so their slots all have the same size.
+static int lsml_oa_slots_list(size_t cap) {
+    for (int i = 0; i < LSML_FREE_SLOTS_LISTS; i++) {
+        if (cap == (size_t) LSML_OA_GROUP_LEN << i) return i;
+    }
+    return -1;
+}
+
+// Claims the first empty slot for an entry with given hash, which must not already be in the hashmap.
+// The new entry has its hash set, and the rest of it is left to the caller.
+// n_elems counts deleted slots too.
+// Returns NULL if the hashmap could not grow and has only one empty slot left, which lookups need,
+// or if it keeps its order and is at its load factor.
+static lsml_oa_entry_t *lsml_oa_put(lsml_oa_t *oa, size_t n_elems, size_t entry_size, lsml_hash_t hash) {
+    if (n_elems + 1 >= oa->cap) return NULL;
+    if (oa->order && n_elems >= lsml_oa_max_elems(oa->cap)) return NULL;
+    size_t group_mask = oa->cap/LSML_OA_GROUP_LEN - 1;
+    size_t group = lsml_oa_h1(hash) & group_mask;
+    for (size_t step = 1; ; step++) {
+        unsigned char *ctrl = oa->ctrl + group*LSML_OA_GROUP_LEN;
+        uint32_t mask = lsml_oa_match(ctrl, LSML_OA_EMPTY);
+        if (mask) {
+            size_t index = group*LSML_OA_GROUP_LEN + lsml_ctz(mask);
+            lsml_oa_entry_t *entry = lsml_oa_slot(oa, entry_size, index);
+            oa->ctrl[index] = lsml_oa_h2(hash);
+            if (oa->order) oa->order[n_elems] = (uint32_t) index;
+            entry->hash = hash;
+            return entry;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+// Allocates the control bytes and slots of an empty hashmap with the given capacity.
+// If ordered is nonzero, the hashmap keeps the order its entries were added in.
+static lsml_err_t lsml_oa_init(lsml_bump_alloc_t *alloc, lsml_oa_t *oa, size_t entry_size, size_t cap, int ordered) {
+    const char *og_mem = alloc->mem;
+    size_t og_offset = alloc->offset;
+    uint32_t *order = NULL;
+    if (ordered && (uint64_t) cap > UINT32_MAX) return LSML_ERR_OUT_OF_MEMORY; // slots are stored in 32 bits
+    unsigned char *ctrl = NULL;
+    int list = ordered ? lsml_oa_slots_list(cap) : -1;
+    char *slots = list >= 0 ? (char *) lsml_bump_reuse(alloc, list) : NULL;
+    if (slots) {
+        // the control bytes and order of slots which were given back are stored in the slots (see lsml_oa_free_slots)
+        memcpy(&ctrl, slots + sizeof(void *), sizeof(ctrl));
+        memcpy(&order, slots + 2*sizeof(void *), sizeof(order));
+    } else {
+        slots = (char *) lsml_bump_alloc(alloc, cap*entry_size, LSML_ALIGNOF(lsml_oa_entry_t));
+        if (slots == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        ctrl = (unsigned char *) lsml_bump_alloc(alloc, cap, 1);
+        if (ctrl && ordered) order = (uint32_t *) lsml_bump_alloc(alloc, lsml_oa_max_elems(cap)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+        if (ctrl == NULL || (ordered && order == NULL)) { lsml_bump_rewind(alloc, og_mem, og_offset); return LSML_ERR_OUT_OF_MEMORY; }
+    }
+    memset(ctrl, LSML_OA_EMPTY, cap);
+    oa->ctrl = ctrl;
+    oa->slots = slots;
+    oa->order = order;
+    oa->cap = cap;
+    oa->n_deleted = 0;
+    return LSML_OK;
+}
+
+// Gives back the slots of an ordered hashmap which was rebuilt, with its control bytes and order.
+static void lsml_oa_free_slots(lsml_bump_alloc_t *alloc, const lsml_oa_t *oa) {
+    int list = lsml_oa_slots_list(oa->cap);
+    if (list < 0) return;
+    char *slots = (char *) oa->slots;
+    memcpy(slots + sizeof(void *), &oa->ctrl, sizeof(oa->ctrl));
+    memcpy(slots + 2*sizeof(void *), &oa->order, sizeof(oa->order));
+    lsml_bump_free(alloc, list, slots);
+}
+
+// Call before inserting n_adding new elements into a hashmap with n_elems elements, or after with n_adding as 0.
+// If the number of elements and deleted slots exceeds the load factor, then this moves every entry into a hashmap
+// of twice the capacity, or as many times that as it takes to fit them all.
+// If at most half of the load factor is left once deleted slots are dropped, the capacity stays the same instead.
+// Hashmaps which had entries removed give back their old slots, since they may be rebuilt many times.
+static lsml_err_t lsml_oa_grow_if_needed(lsml_bump_alloc_t *alloc, lsml_oa_t *oa, size_t n_elems, size_t n_adding, size_t entry_size) {
+    if (!lsml_oa_over_load(n_elems + oa->n_deleted + n_adding, oa->cap)) return LSML_OK;
+    lsml_oa_t old = *oa;
+    size_t cap = old.cap*2;
+    if (old.n_deleted && !lsml_oa_over_load(2*(n_elems + n_adding), old.cap)) cap = old.cap;
+    while (lsml_oa_over_load(n_elems + n_adding, cap)) cap *= 2;
+    lsml_err_t err = lsml_oa_init(alloc, oa, entry_size, cap, old.order != NULL);
+    if (err) return err;
+    if (old.order) {
+        // entries move in the order they were added, which keeps it
+        size_t position = 0;
+        for (size_t i = 0; i < n_elems; i++) {
+            lsml_oa_entry_t *entry = lsml_oa_next(&old, n_elems, entry_size, &position);
+            memcpy(lsml_oa_put(oa, i, entry_size, entry->hash), entry, entry_size);
+        }
+        if (old.n_deleted) lsml_oa_free_slots(alloc, &old);
+        return LSML_OK;
+    }
+    size_t n_moved = 0;
+    for (size_t i = 0; i < old.cap; i++) {
+        if (old.ctrl[i] & LSML_OA_EMPTY) continue;
+        lsml_oa_entry_t *entry = lsml_oa_slot(&old, entry_size, i);
+        memcpy(lsml_oa_put(oa, n_moved, entry_size, entry->hash), entry, entry_size);
+        n_moved += 1;
+    }
+    return LSML_OK;
+}
+
+// --- Minimal Perfect Hash
+
+// Built for the fixed keys of a frozen data, like PTHash: keys are split into buckets of about LSML_MPH_BUCKET_LEN keys,
+// and the buckets are placed from the largest to the smallest, each trying pilots 0, 1, 2, ...
+// until its keys land on indices which no key has taken yet.
+// A lookup is then one pilot and one key comparison, with no probing.
+
+#define LSML_MPH_BUCKET_LEN 4
+
+// Maps x to [0, n), by the high half of x*n.
+static inline size_t lsml_mph_reduce(uint64_t x, size_t n) {
+    uint64_t b = (uint64_t) n;
+    lsml_wymum(&x, &b);
+    return (size_t) b;
+}
+
+static inline size_t lsml_mph_bucket(lsml_hash_t hash, size_t n_buckets) {
+    return lsml_mph_reduce(hash, n_buckets);
+}
+
+static inline size_t lsml_mph_place(lsml_hash_t hash, uint32_t pilot, size_t n_keys) {
+    return lsml_mph_reduce(lsml_wymix(hash ^ lsml_wyp[0], (uint64_t) pilot ^ lsml_wyp[1]), n_keys);
+}
+
+// Gets the index of a key among the n_keys the hash was built with.
+// A key which was not one of them still gets an index, so the key there must be compared.
+static inline size_t lsml_mph_index(const lsml_mph_t *mph, lsml_hash_t hash, size_t n_keys) {
+    return lsml_mph_place(hash, mph->pilots[lsml_mph_bucket(hash, mph->n_buckets)], n_keys);
+}
+
+static size_t lsml_mph_n_buckets(size_t n_keys) {
+    return (n_keys + LSML_MPH_BUCKET_LEN - 1) / LSML_MPH_BUCKET_LEN;
+}
+
+// If hash a is placed before hash b: larger buckets first, then by bucket, then by hash.
+static inline int lsml_mph_before(lsml_hash_t a, lsml_hash_t b, const uint32_t *sizes, size_t n_buckets) {
+    size_t bucket_a = lsml_mph_bucket(a, n_buckets), bucket_b = lsml_mph_bucket(b, n_buckets);
+    if (sizes[bucket_a] != sizes[bucket_b]) return sizes[bucket_a] > sizes[bucket_b];
+    if (bucket_a != bucket_b) return bucket_a < bucket_b;
+    return a < b;
+}
+
+static void lsml_mph_sift_down(lsml_hash_t *hashes, size_t root, size_t n, const uint32_t *sizes, size_t n_buckets) {
+    for (;;) {
+        size_t child = 2*root + 1;
+        if (child >= n) return;
+        if (child + 1 < n && lsml_mph_before(hashes[child], hashes[child + 1], sizes, n_buckets)) child += 1;
+        if (!lsml_mph_before(hashes[root], hashes[child], sizes, n_buckets)) return;
+        lsml_hash_t tmp = hashes[root];
+        hashes[root] = hashes[child];
+        hashes[child] = tmp;
+        root = child;
+    }
+}
+
+// Heap sorts the hashes into the order their buckets are placed in, without any more memory.
+static void lsml_mph_sort(lsml_hash_t *hashes, size_t n, const uint32_t *sizes, size_t n_buckets) {
+    for (size_t i = n/2; i-- > 0;) lsml_mph_sift_down(hashes, i, n, sizes, n_buckets);
+    for (size_t end = n; end-- > 1;) {
+        lsml_hash_t tmp = hashes[0];
+        hashes[0] = hashes[end];
+        hashes[end] = tmp;
+        lsml_mph_sift_down(hashes, 0, end, sizes, n_buckets);
+    }
+}
+
+// Finds the pilots for the keys with the given hashes, which start the scratch memory, followed by room for a bit per key.
+// mph->pilots must have room for lsml_mph_n_buckets(n_keys) pilots.
+// Returns nonzero if two keys have the same hash, so no pilot can separate them.
+static int lsml_mph_build(lsml_mph_t *mph, void *scratch, size_t n_keys) {
+    lsml_hash_t *hashes = (lsml_hash_t *) scratch;
+    unsigned char *taken = (unsigned char *) (hashes + n_keys);
+    size_t n_buckets = lsml_mph_n_buckets(n_keys);
+    mph->n_buckets = n_buckets;
+    // the pilots hold the size of each bucket until the hashes are sorted
+    memset(mph->pilots, 0, n_buckets*sizeof(uint32_t));
+    for (size_t i = 0; i < n_keys; i++) mph->pilots[lsml_mph_bucket(hashes[i], n_buckets)] += 1;
+    lsml_mph_sort(hashes, n_keys, mph->pilots, n_buckets);
+    memset(taken, 0, (n_keys + 7)/8);
+    size_t start = 0;
+    while (start < n_keys) {
+        size_t bucket = lsml_mph_bucket(hashes[start], n_buckets);
+        size_t end = start + 1;
+        for (; end < n_keys && lsml_mph_bucket(hashes[end], n_buckets) == bucket; end++) {
+            if (hashes[end] == hashes[end - 1]) return 1;
+        }
+        for (uint32_t pilot = 0; ; pilot++) {
+            size_t i = start;
+            for (; i < end; i++) {
+                size_t index = lsml_mph_place(hashes[i], pilot, n_keys);
+                if (taken[index/8] & (1u << index%8)) break;
+                taken[index/8] |= (unsigned char) (1u << index%8);
+            }
+            if (i == end) {
+                mph->pilots[bucket] = pilot;
+                break;
+            }
+            // give back the indices taken by the keys before the one which collided
+            while (i-- > start) {
+                size_t index = lsml_mph_place(hashes[i], pilot, n_keys);
+                taken[index/8] &= (unsigned char) ~(1u << index%8);
+            }
+            if (pilot == UINT32_MAX) return 1;
+        }
+        start = end;
     }
+    return 0;
+}
+
+// ---- Reading Data
+
+static lsml_hash_t lsml_hash_seed_default(const lsml_data_t *data) {
+    return lsml_wymix((uint64_t) (uintptr_t) data ^ lsml_wyp[2], lsml_wyp[3]);
+}
+
+// Allocates the empty hashmaps of a data, right after the data itself.
+// If a frozen data has no room for the sections hashmap, it is left as it was,
+// and if it has no room for the strings hashmap, it stays frozen with no sections.
+static lsml_err_t lsml_data_init(lsml_data_t *data) {
     data->sections_head = (lsml_section_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_section_chunk_t), LSML_ALIGNOF(lsml_section_chunk_t));
-    data->strings_head = (lsml_strings_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_strings_chunk_t), LSML_ALIGNOF(lsml_strings_chunk_t));
-    if (data->sections_head == NULL || data->strings_head == NULL) return NULL;
+    if (data->sections_head == NULL) return LSML_ERR_OUT_OF_MEMORY;
     memset(data->sections_head, 0, sizeof(lsml_section_chunk_t));
-    memset(data->strings_head, 0, sizeof(lsml_strings_chunk_t));
     data->sections_tail = data->sections_head;
-    data->strings_tail = data->strings_head;
+    data->sections_dir = NULL;
     data->n_sections = 0;
     data->n_section_chunks = 1;
+    data->first_added = NULL;
+    data->last_added = NULL;
     data->n_strings = 0;
-    data->n_strings_chunks = 1;
+    data->frozen_sections = 0;
+    data->frozen_pilots = 0;
+    data->frozen_n_buckets = 0;
+    data->frozen_first = 0;
+    data->frozen_strings = 0;
+    data->alloc.free_lists = NULL;
+    if (lsml_oa_init(&data->alloc, &data->strings, sizeof(lsml_oa_entry_t), LSML_OA_GROUP_LEN, 0)) {
+        data->strings.cap = 0;
+        return LSML_ERR_OUT_OF_MEMORY;
+    }
+    data->frozen = 0;
+    return LSML_OK;
+}
+
+// Creates a data in the given allocator's memory.
+static lsml_data_t *lsml_data_new_internal(lsml_bump_alloc_t alloc) {
+    lsml_data_t *data = (lsml_data_t*) lsml_bump_alloc(&alloc, sizeof(lsml_data_t), LSML_ALIGNOF(lsml_data_t));
+    if (data == NULL) return NULL;
+    data->alloc = alloc;
+    if (lsml_data_init(data)) return NULL;
+    // the default seed comes from where the data is, which differs between runs with address space randomization
+    data->hash_seed = lsml_hash_seed_default(data);
+    data->err_log = NULL;
+    data->err_log_userdata = NULL;
+    return data;
+}
+
+lsml_data_t *lsml_data_new(void *buf, size_t size) {
+    lsml_bump_alloc_t alloc = {0};
+    alloc.mem = (char*) buf;
+    alloc.size = size;
+    return lsml_data_new_internal(alloc);
+}
+
+lsml_data_t *lsml_data_new_growable(lsml_allocator_t allocator, size_t initial_size) {
+    lsml_bump_alloc_t alloc = {0};
+    // the first block must hold the data itself
+    size_t min_size = sizeof(lsml_block_t) + sizeof(lsml_data_t) + sizeof(lsml_section_chunk_t) + LSML_OA_GROUP_LEN*(sizeof(lsml_oa_entry_t) + 1) + 4*sizeof(lsml_max_align_t);
+    if (initial_size < min_size) initial_size = min_size;
+    if (allocator.alloc == NULL) {
+        allocator.alloc = lsml_default_alloc;
+        allocator.free = lsml_default_free;
+    }
+    lsml_block_t *block = (lsml_block_t *) allocator.alloc(allocator.userdata, initial_size);
+    if (block == NULL) return NULL;
+    block->prev = NULL;
+    block->size = initial_size;
+    alloc.mem = (char *) block;
+    alloc.offset = sizeof(lsml_block_t);
+    alloc.size = initial_size;
+    alloc.block = block;
+    alloc.allocator = allocator;
+    lsml_data_t *data = lsml_data_new_internal(alloc);
+    if (data == NULL && allocator.free) allocator.free(allocator.userdata, block, initial_size);
     return data;
 }
 
+void lsml_data_free(lsml_data_t *data) {
+    if (data == NULL || data->alloc.block == NULL) return;
+    // the data is in one of the blocks, so copy what's needed before freeing it
+    lsml_allocator_t allocator = data->alloc.allocator;
+    lsml_block_t *block = data->alloc.block;
+    if (allocator.free == NULL) return;
+    while (block) {
+        lsml_block_t *prev = block->prev;
+        allocator.free(allocator.userdata, block, block->size);
+        block = prev;
+    }
+}
+
+lsml_err_t lsml_data_set_seed(lsml_data_t *data, uint64_t seed) {
+    if (data == NULL) return LSML_ERR_INVALID_DATA;
+    // existing strings and sections were hashed with the old seed
+    if (data->n_strings != 0 || data->n_sections != 0 || data->frozen) return LSML_ERR_INVALID_DATA;
+    data->hash_seed = seed;
+    return LSML_OK;
+}
+
 void *lsml_data_buffer(lsml_data_t *data, size_t *size_result) {
   if (data == NULL) return NULL;
   if (size_result) *size_result = data->alloc.size;
+  // a frozen data starts its buffer, and doesn't point to it
+  if (data->frozen) return (void *)data;
   return (void *)data->alloc.mem;
 }
 
+// Gives back every block of a growable data except the one holding the data itself, which becomes the only block.
+// That is the first block, unless the data was compacted in place (see lsml_compact_adopt).
+static lsml_block_t *lsml_data_free_other_blocks(lsml_data_t *data) {
+    lsml_block_t *home = NULL;
+    lsml_block_t *block = data->alloc.block;
+    while (block) {
+        lsml_block_t *prev = block->prev;
+        if ((char *) data >= (char *) block && (char *) data < (char *) block + block->size) home = block;
+        else if (data->alloc.allocator.free) data->alloc.allocator.free(data->alloc.allocator.userdata, block, block->size);
+        block = prev;
+    }
+    home->prev = NULL;
+    return home;
+}
+
 void lsml_data_clear(lsml_data_t *data) {
     if (data == NULL) return;
+    // go back to the block which holds the data
+    if (data->alloc.block) {
+        lsml_block_t *home = lsml_data_free_other_blocks(data);
+        data->alloc.block = home;
+        data->alloc.mem = (char *) home;
+        data->alloc.size = home->size;
+        data->alloc.used = 0;
+    }
+    if (data->frozen) data->alloc.mem = (char *) data;
     // data offset may not be 0 if original memory buffer was misaligned
     size_t data_offset = (size_t) ((char*)data - data->alloc.mem);
     size_t new_offset = data_offset + sizeof(lsml_data_t);
     data->alloc.offset = new_offset;
+    lsml_data_init(data);
 }
 
 size_t lsml_data_mem_usage(const lsml_data_t *data) {
     if (data == NULL) return 0;
-    return data->alloc.offset;
+    return data->alloc.used + data->alloc.offset;
 }
 
 size_t lsml_data_section_count(const lsml_data_t *data) {
@@ -507,82 +1280,67 @@ size_t lsml_data_section_count(const lsml_data_t *data) {
     return data->n_sections;
 }
 
-lsml_err_t lsml_data_copy(lsml_data_t *dest, const lsml_data_t *src, int overwrite_conflicts) {
-    if (dest == NULL || src == NULL) return LSML_ERR_INVALID_DATA;
-    lsml_iter_t section_iter = {0};
-    lsml_section_t *section;
-    lsml_section_type_t section_type;
-    lsml_string_t key, value;
-    while(lsml_data_next_section(src, &section_iter, &section, &section_type)) {
-        lsml_iter_t values_iter = {0};
-        if (section_type == LSML_TABLE) {
-            while(lsml_table_next(section, &values_iter, &key, &value)) {
-                // APPEND ENTRY TO DATA
-            }
-        } else if (section_type == LSML_ARRAY) {
-            while(lsml_array_next(section, &values_iter, &value)) {
-                // APPEND ENTRY TO DATA
-            }
-        }
-    }
-    (void) overwrite_conflicts;
-    return LSML_OK;
-}
-
 // Registers a string with the data. This has the following effects:
 // - The passed string may have its pointer overwritten with an extisting string with equivalent data
 // - The data "owns" the string after this operation
 // - If move_string is true, then the passed string is not copied and instead becomes owned by the data.
-//     - NOTE: if the string is not null-terminated, this will return an error.
+//     - NOTE: the string must be null-terminated, except in the scratch data of lsml_parse_parallel workers.
 //
-// NOTE: this does not rehash the strings table, so call hm_rehash_if_needed before/after calling to ensure good performance!
+// The strings table grows after a new string is added, and if it can't, the next new string fails with OUT_OF_MEMORY instead.
 // static lsml_err_t lsml_data_register_string(lsml_data_t *data, lsml_string_t *string) {
 static lsml_err_t lsml_data_register_string(lsml_data_t *data, const char *string, size_t string_len, int move_string, lsml_reg_str_t **reg_str) {
-    if (data == NULL) return LSML_ERR_INVALID_DATA;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
     if (string == NULL) return LSML_ERR_INVALID_KEY;
     lsml_string_t str = lsml_string_init(string, string_len);
-    lsml_index_t hash = lsml_hash_string(&str);
-    size_t index = lsml_mod_chunklen(hash, data->n_strings_chunks*LSML_CHUNK_LEN);
-    void **bucket_ptr = lsml_cha_get_bucket(data->strings_head, data->n_strings_chunks, index);
-    // if (bucket_ptr == NULL) return LSML_ERR_NOT_FOUND; // This should never happen, since lsml_mod restricts index to be in-bounds
-    lsml_hm_node_t *node = (lsml_hm_node_t *) *bucket_ptr;
-    lsml_hm_node_t *prevnode = NULL;
-    while (node != NULL) {
-        if (lsml_string_eq(&node->str->string, &str)) {
-            if (reg_str) *reg_str = node->str;
-            return LSML_OK;
-        }
-        prevnode = node;
-        node = node->next;
+    lsml_hash_t hash = lsml_hash_string(&str, data->hash_seed);
+    lsml_oa_entry_t *entry = lsml_oa_find(&data->strings, sizeof(lsml_oa_entry_t), hash, &str, NULL);
+    if (entry) {
+        if (reg_str) *reg_str = entry->str;
+        return LSML_OK;
     }
-    // Node is null, so this key isn't present, so create a new node for it and copy string data
+    // This string isn't present, so create a new entry for it and copy string data
+    if (data->n_strings + 1 >= data->strings.cap) return LSML_ERR_OUT_OF_MEMORY; // the strings table failed to grow
+    const char *og_mem = data->alloc.mem;
     size_t og_offset = data->alloc.offset;
-    node = (lsml_hm_node_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_hm_node_t), LSML_ALIGNOF(lsml_hm_node_t));
-    if (node == NULL) return LSML_ERR_OUT_OF_MEMORY;
     lsml_reg_str_t *reg = (lsml_reg_str_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_reg_str_t), LSML_ALIGNOF(lsml_reg_str_t));
-    if (reg == NULL) { data->alloc.offset = og_offset; return LSML_ERR_OUT_OF_MEMORY; }
+    if (reg == NULL) return LSML_ERR_OUT_OF_MEMORY;
     reg->hash = hash;
     if (move_string) {
-        if (str.str[str.len] != 0) return LSML_ERR_INVALID_KEY;
         reg->string = str;
     } else {
         char *buf;
         buf = (char *) lsml_bump_alloc(&data->alloc, str.len+1, LSML_ALIGNOF(char));
-        if (buf == NULL) { data->alloc.offset = og_offset; return LSML_ERR_OUT_OF_MEMORY; }
+        if (buf == NULL) { lsml_bump_rewind(&data->alloc, og_mem, og_offset); return LSML_ERR_OUT_OF_MEMORY; }
         memcpy(buf, str.str, str.len);
         buf[str.len] = 0; // null terminator
         reg->string = lsml_string_init(buf, str.len);
     }
-    // node init
-    node->next = NULL;
-    node->str = reg;
-    if (prevnode) prevnode->next = node;
-    else *bucket_ptr = node;
+    entry = lsml_oa_put(&data->strings, data->n_strings, sizeof(lsml_oa_entry_t), hash);
+    entry->str = reg;
     data->n_strings += 1;
     if (reg_str) *reg_str = reg;
+    lsml_oa_grow_if_needed(&data->alloc, &data->strings, data->n_strings, 0, sizeof(lsml_oa_entry_t));
     return LSML_OK;
 }
 
+// Empties a section, keeping its name and its place in the order sections were added.
+// It becomes an array with the given row starts, which have room for one row, or a table if they are NULL.
+static void lsml_section_init(lsml_data_t *data, lsml_section_t *section, size_t *row_starts) {
+    lsml_hm_node_t node = section->node;
+    lsml_section_t *next_added = section->next_added;
+    memset(section, 0, sizeof(lsml_section_t));
+    section->node = node;
+    section->next_added = next_added;
+    section->hash_seed = data->hash_seed;
+    section->row_starts = row_starts;
+    if (row_starts) {
+        row_starts[0] = 0;
+        section->n_rows = 1;
+        section->min_cols = (size_t) -1;
+        section->max_cols = 0;
+    }
+}
+
 // Creates a new section with given name and type.
 // May return one the following errors:
 // - Invalid data: data is NULL
@@ -590,25 +1348,29 @@ static lsml_err_t lsml_data_register_string(lsml_data_t *data, const char *strin
 // - Section name reused: section of that name already exists
 static lsml_err_t lsml_data_add_section_internal(lsml_data_t *data, lsml_reg_str_t *section_name, lsml_section_type_t section_type, lsml_section_t **section) {
     if (data == NULL) return LSML_ERR_INVALID_DATA;
-    lsml_err_t err = lsml_hm_rehash_if_needed(&data->alloc, data->sections_head, (void**) &data->sections_tail, data->n_sections, &data->n_section_chunks);
+    lsml_err_t err = lsml_hm_rehash_if_needed(&data->alloc, data->sections_head, (void**) &data->sections_tail, (void***) &data->sections_dir, data->n_sections, &data->n_section_chunks);
     if (err) return err;
+    const char *og_mem = data->alloc.mem;
+    size_t og_offset = data->alloc.offset;
+    // an array's row starts are allocated first, so running out of memory never leaves a section of the wrong type
+    size_t *row_starts = NULL;
+    if (section_type == LSML_ARRAY) {
+        row_starts = (size_t *) lsml_bump_alloc(&data->alloc, sizeof(size_t), LSML_ALIGNOF(size_t));
+        if (row_starts == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    }
     int was_created = 0;
     lsml_section_t *node = (lsml_section_t *) lsml_hm_get_or_create_node(
-        &data->alloc, data->sections_head, &data->n_sections, data->n_section_chunks, section_name,
+        &data->alloc, data->sections_head, (void**) data->sections_dir, &data->n_sections, data->n_section_chunks, section_name,
         sizeof(lsml_section_t), LSML_ALIGNOF(lsml_section_t), &was_created
     );
-    if (!was_created) return LSML_ERR_SECTION_NAME_REUSED;
-    if (node == NULL) return LSML_ERR_OUT_OF_MEMORY;
-    // Removed b/c get_or_create_node memset's to zero
-    if (section_type == LSML_ARRAY) {
-        node->row_indices = lsml_bump_alloc(&data->alloc, sizeof(lsml_rows_index_t), LSML_ALIGNOF(lsml_rows_index_t));
-        if (node->row_indices == NULL) return LSML_ERR_OUT_OF_MEMORY;
-        memset(node->row_indices, 0, sizeof(lsml_rows_index_t));
-        node->last_row_index = node->row_indices;
-    } else {
-        node->row_indices = NULL;
-        node->last_row_index = NULL;
+    if (node == NULL || !was_created) {
+        lsml_bump_rewind(&data->alloc, og_mem, og_offset);
+        return node == NULL ? LSML_ERR_OUT_OF_MEMORY : LSML_ERR_SECTION_NAME_REUSED;
     }
+    if (data->last_added) data->last_added->next_added = node;
+    else data->first_added = node;
+    data->last_added = node;
+    lsml_section_init(data, node, row_starts);
     if (section) *section = node;
     return LSML_OK;
 }
@@ -623,76 +1385,188 @@ static lsml_err_t lsml_data_add_section_internal(lsml_data_t *data, lsml_reg_str
 static lsml_err_t lsml_table_add_entry_internal(lsml_data_t *data, lsml_section_t *table, lsml_reg_str_t *key, lsml_reg_str_t *value) {
     if (data == NULL) return LSML_ERR_INVALID_DATA;
     if (table == NULL) return LSML_ERR_INVALID_SECTION;
-    if (table->row_indices != NULL) return LSML_ERR_SECTION_TYPE;
-    if (table->section.table == NULL) {
-        table->section.table = (lsml_table_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_cha_chunk_t), LSML_ALIGNOF(lsml_cha_chunk_t));
-        if (table->section.table == NULL) return LSML_ERR_OUT_OF_MEMORY;
-        memset(table->section.table, 0, sizeof(lsml_table_chunk_t));
-        table->n_chunks = 1;
-        table->last_chunk.table = table->section.table;
-    }
-    lsml_err_t err = lsml_hm_rehash_if_needed(&data->alloc, table->section.table, (void**) &table->last_chunk.table, table->n_elems, &table->n_chunks);
+    if (table->row_starts != NULL) return LSML_ERR_SECTION_TYPE;
+    lsml_err_t err;
+    if (table->section.table.cap == 0) {
+        err = lsml_oa_init(&data->alloc, &table->section.table, sizeof(lsml_table_entry_t), LSML_OA_GROUP_LEN, 1);
+        if (err) return err;
+    }
+    if (lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), key->hash, NULL, key)) return LSML_ERR_TABLE_KEY_REUSED;
+    err = lsml_oa_grow_if_needed(&data->alloc, &table->section.table, table->n_elems, 1, sizeof(lsml_table_entry_t));
     if (err) return err;
-    int was_created = 0;
-    lsml_table_node_t *node = (lsml_table_node_t *) lsml_hm_get_or_create_node(
-        &data->alloc, table->section.table, &table->n_elems, table->n_chunks, key,
-        sizeof(lsml_table_node_t), LSML_ALIGNOF(lsml_table_node_t), &was_created
-    );
-    if (node == NULL) return LSML_ERR_OUT_OF_MEMORY;
-    if (!was_created) return LSML_ERR_TABLE_KEY_REUSED;
-    node->value = &value->string;
-    // if (entry) *entry = node;
+    lsml_table_entry_t *entry = (lsml_table_entry_t *) lsml_oa_put(&table->section.table, table->n_elems + table->section.table.n_deleted, sizeof(lsml_table_entry_t), key->hash);
+    if (entry == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    entry->entry.str = key;
+    entry->value = value->string;
+    table->n_elems += 1;
     return LSML_OK;
 }
 
-static lsml_err_t lsml_array_add_entry_internal(lsml_data_t *data, lsml_section_t *array, lsml_string_t *value, int newrow) {
+// Makes room in a table for n_adding more entries at once, rather than growing it as they are added.
+static lsml_err_t lsml_table_reserve(lsml_data_t *data, lsml_section_t *table, size_t n_adding) {
+    lsml_oa_t *oa = &table->section.table;
+    if (oa->cap == 0) {
+        size_t cap = LSML_OA_GROUP_LEN;
+        while (lsml_oa_over_load(n_adding, cap)) cap *= 2;
+        return lsml_oa_init(&data->alloc, oa, sizeof(lsml_table_entry_t), cap, 1);
+    }
+    return lsml_oa_grow_if_needed(&data->alloc, oa, table->n_elems, n_adding, sizeof(lsml_table_entry_t));
+}
+
+// Counts a row which is done growing in an array's number of rows of each width, if it keeps them.
+// If there is no room for the counts to cover a wider row, they are dropped, and counted again when a row is next removed.
+static void lsml_array_count_row(lsml_data_t *data, lsml_section_t *array, size_t cols) {
+    if (array->width_rows == NULL) return;
+    if (cols >= array->width_cap) {
+        size_t cap = array->width_cap;
+        while (cap <= cols) cap *= 2;
+        // the old counts are abandoned
+        size_t *width_rows = (size_t *) lsml_bump_alloc(&data->alloc, cap*sizeof(size_t), LSML_ALIGNOF(size_t));
+        if (width_rows == NULL) {
+            array->width_rows = NULL;
+            return;
+        }
+        memcpy(width_rows, array->width_rows, array->width_cap*sizeof(size_t));
+        memset(width_rows + array->width_cap, 0, (cap - array->width_cap)*sizeof(size_t));
+        array->width_rows = width_rows;
+        array->width_cap = cap;
+    }
+    array->width_rows[cols] += 1;
+}
+
+static lsml_err_t lsml_array_add_entry_internal(lsml_data_t *data, lsml_section_t *array, const lsml_string_t *value, int newrow) {
     if (data == NULL) return LSML_ERR_INVALID_DATA;
     if (array == NULL) return LSML_ERR_INVALID_SECTION;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
+    if (array->row_starts == NULL) return LSML_ERR_SECTION_TYPE;
+    newrow = newrow && array->n_elems > 0; // the first element always starts the first row
+    if (newrow && (array->n_rows & (array->n_rows - 1)) == 0) {
+        // the row starts are full, the old ones are abandoned
+        size_t *row_starts = (size_t *) lsml_bump_alloc(&data->alloc, 2*array->n_rows*sizeof(size_t), LSML_ALIGNOF(size_t));
+        if (row_starts == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        memcpy(row_starts, array->row_starts, array->n_rows*sizeof(size_t));
+        array->row_starts = row_starts;
+    }
     if (array->section.array == NULL) {
-        array->section.array = (lsml_array_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_cha_chunk_t), LSML_ALIGNOF(lsml_cha_chunk_t));
+        array->section.array = (lsml_array_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_array_chunk_t), LSML_ALIGNOF(lsml_array_chunk_t));
         if (array->section.array == NULL) return LSML_ERR_OUT_OF_MEMORY;
-        memset(array->section.array, 0, sizeof(lsml_table_chunk_t));
+        memset(array->section.array, 0, sizeof(lsml_array_chunk_t));
         array->n_chunks = 1;
-        array->last_chunk.array = array->section.array;
+        array->last_chunk = array->section.array;
     }
     
-    if (array->n_elems >= (array->n_chunks*LSML_CHUNK_LEN)) {
+    if (array->n_elems >= (array->n_chunks*LSML_ARRAY_CHUNK_LEN) && array->last_chunk->next) {
+        // a chunk left over from removing values, which is still in the directory
+        array->last_chunk = array->last_chunk->next;
+        array->n_chunks += 1;
+    } else if (array->n_elems >= (array->n_chunks*LSML_ARRAY_CHUNK_LEN)) {
+        const char *og_mem = data->alloc.mem;
+        size_t og_offset = data->alloc.offset;
+        lsml_array_chunk_t **dir = array->array_dir;
+        if ((array->n_chunks & (array->n_chunks - 1)) == 0) {
+            // the directory is full, the old one is abandoned
+            dir = (lsml_array_chunk_t **) lsml_bump_alloc(&data->alloc, 2*array->n_chunks*sizeof(void *), LSML_ALIGNOF(void *));
+            if (dir == NULL) return LSML_ERR_OUT_OF_MEMORY;
+            if (array->array_dir) memcpy(dir, array->array_dir, array->n_chunks*sizeof(void *));
+            else dir[0] = array->section.array;
+        }
         lsml_array_chunk_t *cha_new = (lsml_array_chunk_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_array_chunk_t), LSML_ALIGNOF(lsml_array_chunk_t));
-        if (cha_new == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        if (cha_new == NULL) { lsml_bump_rewind(&data->alloc, og_mem, og_offset); return LSML_ERR_OUT_OF_MEMORY; }
         memset(cha_new, 0, sizeof(lsml_array_chunk_t));
-        array->last_chunk.array->next = cha_new;
-        array->last_chunk.array = cha_new;
+        dir[array->n_chunks] = cha_new;
+        array->array_dir = dir;
+        array->last_chunk->next = cha_new;
+        array->last_chunk = cha_new;
         array->n_chunks += 1;
     }
-    size_t chunk_index = lsml_mod_chunklen(array->n_elems, LSML_CHUNK_LEN);
-    array->last_chunk.array->elems[chunk_index] = value;
-    // NOTE: n_elems should be incremented by 1 here, but not doing so saves some arithmetic in the following if-statement:
-    if (newrow && array->n_elems > 0) {
-        lsml_rows_index_t *new_row_index = (lsml_rows_index_t *) lsml_bump_alloc(&data->alloc, sizeof(lsml_rows_index_t), LSML_ALIGNOF(lsml_rows_index_t));
-        if (new_row_index == NULL) return LSML_ERR_OUT_OF_MEMORY;
-        new_row_index->index = array->n_elems;
-        new_row_index->next = NULL;
-        array->last_row_index->next = new_row_index;
-        array->last_row_index = new_row_index;
+    size_t chunk_index = lsml_mod_chunklen(array->n_elems, LSML_ARRAY_CHUNK_LEN);
+    array->last_chunk->elems[chunk_index] = *value;
+    if (newrow) {
+        // the last row is done growing
+        size_t cols = array->n_elems - array->row_starts[array->n_rows - 1];
+        if (cols < array->min_cols) array->min_cols = cols;
+        if (cols > array->max_cols) array->max_cols = cols;
+        lsml_array_count_row(data, array, cols);
+        array->row_starts[array->n_rows] = array->n_elems;
+        array->n_rows += 1;
     }
     array->n_elems += 1;
     
     return LSML_OK;
 }
 
+// --- Frozen Sections
+// Sections of a frozen data are handed out as lsml_section_t, and read by their own layout (see lsml_data_freeze).
+// Their offsets are turned into pointers here, as they are read.
+
+static inline int lsml_section_frozen(const lsml_section_t *section) {
+    return section->node.str == NULL;
+}
+
+static inline const lsml_frozen_section_t *lsml_frozen_section(const lsml_section_t *section) {
+    return (const lsml_frozen_section_t *) (const void *) section;
+}
+
+// Gets the frozen data holding a frozen section, which its offsets are from.
+static inline const char *lsml_frozen_base(const lsml_frozen_section_t *section) {
+    return (const char *) section - section->self;
+}
+
+static inline lsml_string_t lsml_frozen_string(const char *base, lsml_frozen_str_t str) {
+    lsml_string_t string;
+    string.str = base + str.off;
+    string.len = str.len;
+    return string;
+}
+
+static inline lsml_section_type_t lsml_section_type(const lsml_section_t *section) {
+    if (lsml_section_frozen(section)) return lsml_frozen_section(section)->is_array ? LSML_ARRAY : LSML_TABLE;
+    return section->row_starts ? LSML_ARRAY : LSML_TABLE;
+}
+
+// Gets the value at an index of a frozen array, which must be in it.
+static inline lsml_string_t lsml_frozen_value(const lsml_frozen_section_t *array, size_t index) {
+    const char *base = lsml_frozen_base(array);
+    return lsml_frozen_string(base, ((const lsml_frozen_str_t *) (base + array->elems))[index]);
+}
+
+static inline const uint32_t *lsml_frozen_row_starts(const lsml_frozen_section_t *array) {
+    return (const uint32_t *) (lsml_frozen_base(array) + array->order);
+}
+
 // --- Sections
 
+static lsml_err_t lsml_section_load(lsml_data_t *data, lsml_section_t *section);
+
 lsml_err_t lsml_data_get_section(const lsml_data_t *data, lsml_section_type_t desired_type, const char *name, size_t name_len, lsml_section_t **section_found, lsml_section_type_t *section_type) {
     if (data == NULL) return LSML_ERR_INVALID_DATA;
     lsml_string_t section_name = lsml_string_init(name, name_len);
     if (section_name.str == NULL) return LSML_ERR_INVALID_KEY;
-    lsml_section_t *section = (lsml_section_t *) lsml_hm_get_node(data->sections_head, data->n_section_chunks, &section_name);
-    if (section == NULL) return LSML_ERR_NOT_FOUND;
-    lsml_section_type_t type = section->row_indices ? LSML_ARRAY : LSML_TABLE;
+    lsml_section_t *section;
+    if (data->frozen) {
+        if (data->n_sections == 0) return LSML_ERR_NOT_FOUND;
+        const char *base = (const char *) data;
+        lsml_mph_t mph;
+        mph.pilots = (uint32_t *) (base + data->frozen_pilots);
+        mph.n_buckets = data->frozen_n_buckets;
+        lsml_hash_t hash = lsml_hash_string(&section_name, data->hash_seed);
+        const lsml_frozen_section_t *frozen = (const lsml_frozen_section_t *) (base + data->frozen_sections) + lsml_mph_index(&mph, hash, data->n_sections);
+        lsml_string_t name = lsml_frozen_string(base, frozen->name);
+        if (frozen->name_hash != hash || !lsml_string_eq(&name, &section_name)) return LSML_ERR_NOT_FOUND;
+        section = (lsml_section_t *) frozen;
+    } else {
+        section = (lsml_section_t *) lsml_hm_get_node(data->sections_head, (void**) data->sections_dir, data->n_section_chunks, &section_name, data->hash_seed);
+        if (section == NULL) return LSML_ERR_NOT_FOUND;
+    }
+    lsml_section_type_t type = lsml_section_type(section);
     if (section_type) *section_type = type;
     if (desired_type != LSML_ANYSECTION && desired_type != type) return LSML_ERR_SECTION_TYPE;
-    if (section_found) *section_found = section;
+    if (section_found) {
+        if (!data->frozen && section->lazy_body) {
+            lsml_err_t err = lsml_section_load((lsml_data_t *) data, section);
+            if (err) return err;
+        }
+        *section_found = section;
+    }
     return LSML_OK;
 }
 
@@ -715,29 +1589,24 @@ lsml_err_t lsml_data_get_sections(const lsml_data_t *data, lsml_section_type_t d
 
 int lsml_data_next_section(const lsml_data_t *data, lsml_iter_t *iter, lsml_section_t **section, lsml_section_type_t *section_type) {
     if (data == NULL || iter == NULL) return 0;
-    if (iter->chunk == NULL) {
-        iter->chunk = data->sections_head;
-        iter->index = 0;
-        iter->elem = data->sections_head->buckets[0];
-    } else if (iter->elem) { // try to go to next node in bucket
-        iter->elem = ((lsml_section_t *) iter->elem)->node.next;
-    }
-    while (iter->elem == NULL) { // try to go to next bucket
-        iter->index += 1;
-        if (iter->index >= LSML_CHUNK_LEN) {
-            void *next = ((lsml_section_chunk_t *) iter->chunk)->next;
-            if (next) {
-                iter->chunk = next;
-                iter->index = 0;
-            } else {
-                iter->index = LSML_CHUNK_LEN;
-                return 0;
-            }
-        }
-        iter->elem = ((lsml_section_chunk_t *) iter->chunk)->buckets[iter->index];
+    // sections are visited in the order they were added, and iter->chunk marks that iteration started
+    if (data->frozen) {
+        uint32_t next = data->frozen_first;
+        if (iter->chunk == NULL) iter->chunk = (void *) data;
+        else if (iter->elem) next = ((const lsml_frozen_section_t *) iter->elem)->next_added;
+        else next = 0;
+        iter->elem = next ? (void *) ((const char *) data + next) : NULL;
+    } else if (iter->chunk == NULL) {
+        iter->chunk = (void *) data;
+        iter->elem = data->first_added;
+    } else if (iter->elem) {
+        iter->elem = ((lsml_section_t *) iter->elem)->next_added;
     }
+    if (iter->elem == NULL) return 0;
+    // a section which fails to parse is still returned, with the entries parsed before the failure
+    if (section && !data->frozen && ((lsml_section_t *) iter->elem)->lazy_body) lsml_section_load((lsml_data_t *) data, (lsml_section_t *) iter->elem);
     if (section) *section = (lsml_section_t *) iter->elem;
-    if (section_type) *section_type = ((lsml_section_t *) iter->elem)->row_indices ? LSML_ARRAY : LSML_TABLE;
+    if (section_type) *section_type = lsml_section_type((lsml_section_t *) iter->elem);
     return 1;
 }
 
@@ -748,21 +1617,25 @@ lsml_err_t lsml_data_add_section(lsml_data_t *data, lsml_section_type_t desired_
     if (string.len == 0) return LSML_ERR_INVALID_KEY;
     err = lsml_data_register_string(data, name, name_len, 0, &reg_str);
     if (err) return err;
-    err = lsml_hm_rehash_if_needed(&data->alloc, data->strings_head, (void**) &data->strings_tail, data->n_strings, &data->n_strings_chunks);
-    if (err) return err;
     return lsml_data_add_section_internal(data, reg_str, desired_type, section_created);
 }
 
 lsml_err_t lsml_section_info(const lsml_section_t *section, lsml_string_t *name, lsml_section_type_t *type, size_t *n_elems) {
     if (section == NULL) return LSML_ERR_INVALID_SECTION;
-    if (name) *name = section->node.str->string;
-    if (type) *type = section->row_indices ? LSML_ARRAY : LSML_TABLE;
-    if (n_elems) *n_elems = section->n_elems;
+    if (lsml_section_frozen(section)) {
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(section);
+        if (name) *name = lsml_frozen_string(lsml_frozen_base(frozen), frozen->name);
+    } else if (name) {
+        *name = section->node.str->string;
+    }
+    if (type) *type = lsml_section_type(section);
+    if (n_elems) *n_elems = lsml_section_len(section);
     return LSML_OK;
 }
 
 size_t lsml_section_len(const lsml_section_t *section) {
     if (section == NULL) return 0;
+    if (lsml_section_frozen(section)) return lsml_frozen_section(section)->n_elems;
     return section->n_elems;
 }
 
@@ -771,16 +1644,32 @@ size_t lsml_section_len(const lsml_section_t *section) {
 lsml_err_t lsml_table_get(const lsml_section_t *table, const char *key_name, size_t key_len, lsml_string_t *value) {
     if (table == NULL) return LSML_ERR_INVALID_SECTION;
     // if (table->type != LSML_TABLE) return LSML_ERR_SECTION_TYPE;
-    if (table->row_indices != NULL) return LSML_ERR_SECTION_TYPE;
+    if (lsml_section_type(table) != LSML_TABLE) return LSML_ERR_SECTION_TYPE;
     lsml_string_t key = lsml_string_init(key_name, key_len);
-    lsml_table_node_t *node = (lsml_table_node_t *) lsml_hm_get_node(table->section.table, table->n_chunks, &key);
-    if (node == NULL) return LSML_ERR_NOT_FOUND;
-    if (value) *value = *(node->value);
+    if (key.str == NULL) return LSML_ERR_NOT_FOUND;
+    if (lsml_section_frozen(table)) {
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(table);
+        if (frozen->n_elems == 0) return LSML_ERR_NOT_FOUND;
+        const char *base = lsml_frozen_base(frozen);
+        lsml_mph_t mph;
+        mph.pilots = (uint32_t *) (base + frozen->pilots);
+        mph.n_buckets = frozen->n_buckets;
+        lsml_hash_t hash = lsml_hash_string(&key, ((const lsml_data_t *) base)->hash_seed);
+        const lsml_frozen_entry_t *entry = (const lsml_frozen_entry_t *) (base + frozen->elems) + lsml_mph_index(&mph, hash, frozen->n_elems);
+        lsml_string_t entry_key = lsml_frozen_string(base, entry->key);
+        if (entry->hash != hash || !lsml_string_eq(&entry_key, &key)) return LSML_ERR_NOT_FOUND;
+        if (value) *value = lsml_frozen_string(base, entry->value);
+        return LSML_OK;
+    }
+    lsml_hash_t hash = lsml_hash_string(&key, table->hash_seed);
+    lsml_table_entry_t *entry = (lsml_table_entry_t *) lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), hash, &key, NULL);
+    if (entry == NULL) return LSML_ERR_NOT_FOUND;
+    if (value) *value = entry->value;
     return LSML_OK;
 }
 
 lsml_err_t lsml_table_add_entry(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len, const char *value, size_t value_len) {
-    if (data == NULL) return LSML_ERR_INVALID_DATA;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
     if (!lsml_data_owns_ptr(data, table)) return LSML_ERR_INVALID_SECTION;
     if (value == NULL) return LSML_ERR_VALUE_NULL;
     lsml_string_t key_str = lsml_string_init(key_name, key_len);
@@ -789,136 +1678,434 @@ lsml_err_t lsml_table_add_entry(lsml_data_t *data, lsml_section_t *table, const
     lsml_err_t err;
     err = lsml_data_register_string(data, key_str.str, key_str.len, 0, &key);
     if (err) return err;
-    if(lsml_hm_get_node_reg(table->section.table, table->n_chunks, key)) return LSML_ERR_TABLE_KEY_REUSED;
+    if (lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), key->hash, NULL, key)) return LSML_ERR_TABLE_KEY_REUSED;
     err = lsml_data_register_string(data, value, value_len, 0, &val);
     if (err) return err;
     return lsml_table_add_entry_internal(data, table, key, val);
 }
 
+lsml_err_t lsml_table_set(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len, const char *value, size_t value_len) {
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (!lsml_data_owns_ptr(data, table)) return LSML_ERR_INVALID_SECTION;
+    if (table->row_starts != NULL) return LSML_ERR_SECTION_TYPE;
+    if (value == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_string_t key_str = lsml_string_init(key_name, key_len);
+    if (key_str.len == 0) return LSML_ERR_INVALID_KEY;
+    lsml_reg_str_t *key, *val;
+    lsml_err_t err;
+    err = lsml_data_register_string(data, key_str.str, key_str.len, 0, &key);
+    if (err) return err;
+    err = lsml_data_register_string(data, value, value_len, 0, &val);
+    if (err) return err;
+    lsml_table_entry_t *entry = (lsml_table_entry_t *) lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), key->hash, NULL, key);
+    if (entry == NULL) return lsml_table_add_entry_internal(data, table, key, val);
+    // the old value stays registered, since other entries may share it
+    entry->value = val->string;
+    return LSML_OK;
+}
+
+lsml_err_t lsml_table_remove(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len) {
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (!lsml_data_owns_ptr(data, table)) return LSML_ERR_INVALID_SECTION;
+    if (table->row_starts != NULL) return LSML_ERR_SECTION_TYPE;
+    lsml_string_t key = lsml_string_init(key_name, key_len);
+    if (key.str == NULL) return LSML_ERR_NOT_FOUND;
+    // the key is looked up like lsml_table_get, so a key which was never added isn't registered
+    lsml_hash_t hash = lsml_hash_string(&key, table->hash_seed);
+    lsml_oa_entry_t *entry = lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), hash, &key, NULL);
+    if (entry == NULL) return LSML_ERR_NOT_FOUND;
+    lsml_oa_remove(&table->section.table, sizeof(lsml_table_entry_t), entry);
+    table->n_elems -= 1;
+    return LSML_OK;
+}
+
 int lsml_table_next(const lsml_section_t *table, lsml_iter_t *iter, lsml_string_t *key, lsml_string_t *value) {
-    if (table == NULL || iter == NULL || table->section.table == NULL || table->row_indices != NULL) return 0;
-    if (iter->chunk == NULL) {
-        iter->chunk = table->section.table;
-        iter->index = 0; // chunk index
-        iter->elem = table->section.table->buckets[0];
-    } else if (iter->elem) { // try to go to next node in bucket
-        iter->elem = ((lsml_table_node_t *) iter->elem)->node.next;
-    }
-    while (iter->elem == NULL) { // try to go to next chunk
+    if (table == NULL || iter == NULL || lsml_section_type(table) != LSML_TABLE) return 0;
+    if (lsml_section_frozen(table)) {
+        // entries are visited in the order they were added, by the slots they are in
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(table);
+        if (iter->index >= frozen->n_elems) return 0;
+        const char *base = lsml_frozen_base(frozen);
+        uint32_t slot = ((const uint32_t *) (base + frozen->order))[iter->index];
+        const lsml_frozen_entry_t *entry = (const lsml_frozen_entry_t *) (base + frozen->elems) + slot;
         iter->index += 1;
-        if (iter->index >= LSML_CHUNK_LEN) {
-            void *next_chunk = ((lsml_table_chunk_t *) iter->chunk)->next;
-            if (next_chunk) {
-                iter->chunk = next_chunk;
-                iter->index = 0;
-            } else {
-                iter->index = LSML_CHUNK_LEN;
-                return 0;
-            }
-        }
-        iter->elem = ((lsml_table_chunk_t *) iter->chunk)->buckets[iter->index];
+        if (key) *key = lsml_frozen_string(base, entry->key);
+        if (value) *value = lsml_frozen_string(base, entry->value);
+        return 1;
     }
-    if (key) *key = ((lsml_table_node_t *)iter->elem)->node.str->string;
-    if (value) *value = *(((lsml_table_node_t *)iter->elem)->value);
+    // iter->index is the position in the order the entries were added, which counts removed entries
+    const lsml_oa_t *oa = &table->section.table;
+    lsml_table_entry_t *entry = (lsml_table_entry_t *) lsml_oa_next(oa, table->n_elems, sizeof(lsml_table_entry_t), &iter->index);
+    if (entry == NULL) return 0;
+    if (key) *key = entry->entry.str->string;
+    if (value) *value = entry->value;
     return 1;
 }
 
 
 // -- Array Sections
 
+static lsml_err_t lsml_array_store_value(lsml_data_t *data, lsml_section_t *array, lsml_string_t *string, int move_string, lsml_string_t *value);
+
+// Gets the value at `index` in an array, or NULL if there is none.
+static const lsml_string_t *lsml_array_elem(const lsml_section_t *array, size_t index) {
+    if (array->section.array == NULL || index >= array->n_elems) return NULL;
+    const lsml_array_chunk_t *cha = array->array_dir ? array->array_dir[index / LSML_ARRAY_CHUNK_LEN] : array->section.array;
+    return &cha->elems[index % LSML_ARRAY_CHUNK_LEN];
+}
+
+// Gets the value at an index of an array, frozen or not, which must be in it.
+static inline lsml_string_t lsml_array_value(const lsml_section_t *array, size_t index) {
+    if (lsml_section_frozen(array)) return lsml_frozen_value(lsml_frozen_section(array), index);
+    return *lsml_array_elem(array, index);
+}
+
+static inline size_t lsml_array_n_rows(const lsml_section_t *array) {
+    if (lsml_section_frozen(array)) return lsml_frozen_section(array)->n_rows;
+    return array->n_rows;
+}
+
+static inline size_t lsml_array_row_start(const lsml_section_t *array, size_t row) {
+    if (lsml_section_frozen(array)) return lsml_frozen_row_starts(lsml_frozen_section(array))[row];
+    return array->row_starts[row];
+}
+
 lsml_err_t lsml_array_2d_size(const lsml_section_t *array, int is_jagged, size_t *rows, size_t *cols) {
     if (array == NULL) return LSML_ERR_INVALID_SECTION;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
-    if (rows == NULL && cols == NULL) return LSML_OK; // no need to waste time
-    // need to initialize c to most extreme case
-    size_t r = 0, c = is_jagged ? 0 : array->n_elems;
-    lsml_rows_index_t *row_index = array->row_indices;
-
-    while(row_index) {
-        lsml_rows_index_t *next_row_index = row_index->next;
-        size_t cur_cols;
-        if (next_row_index) {
-            cur_cols = next_row_index->index - row_index->index;
-        } else {
-            cur_cols = array->n_elems - row_index->index;
-        }
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    size_t n_elems = lsml_section_len(array), n_rows = lsml_array_n_rows(array);
+    size_t min_cols, max_cols;
+    if (lsml_section_frozen(array)) {
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(array);
+        min_cols = frozen->min_cols == UINT32_MAX ? SIZE_MAX : frozen->min_cols;
+        max_cols = frozen->max_cols;
+    } else {
+        min_cols = array->min_cols;
+        max_cols = array->max_cols;
+    }
+    size_t last_cols = n_elems - lsml_array_row_start(array, n_rows - 1);
+    // an array with no values has no rows
+    if (rows) *rows = n_elems ? n_rows : 0;
+    if (cols) {
+        if (is_jagged) *cols = max_cols > last_cols ? max_cols : last_cols;
+        else *cols = min_cols < last_cols ? min_cols : last_cols;
+    }
+    return LSML_OK;
+}
 
-        r += 1;
-        if (is_jagged ? (cur_cols > c) : (cur_cols < c)) c = cur_cols;
+// Gets the range of elements [*start, *end) in a row of an array, returning nonzero if the row doesn't exist.
+static inline int lsml_array_row_range(const lsml_section_t *array, size_t row, size_t *start, size_t *end) {
+    size_t n_elems = lsml_section_len(array), n_rows = lsml_array_n_rows(array);
+    if (row >= n_rows || n_elems == 0) return 1;
+    *start = lsml_array_row_start(array, row);
+    *end = row + 1 < n_rows ? lsml_array_row_start(array, row + 1) : n_elems;
+    return 0;
+}
 
-        row_index = next_row_index;
+// Gets the row holding the element at an index of an array, by binary search of the row starts.
+// Empty rows start at the same index as the row after them, so the last row starting at or before the index is found.
+static size_t lsml_array_row_of(const lsml_section_t *array, size_t index) {
+    size_t lo = 0, hi = lsml_array_n_rows(array); // the row is in [lo, hi)
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo)/2;
+        if (lsml_array_row_start(array, mid) <= index) lo = mid;
+        else hi = mid;
     }
-
-    if (rows) *rows = r;
-    if (cols) *cols = c;
-    return LSML_OK;
+    return lo;
 }
 
 lsml_err_t lsml_array_get(const lsml_section_t *array, size_t index, lsml_string_t *value) {
     if (array == NULL) return LSML_ERR_INVALID_SECTION;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
-    lsml_string_t *elem = (lsml_string_t *) lsml_cha_get(array->section.array, array->n_elems, array->n_chunks, index);
-    if (value) *value = *elem;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    if (index >= lsml_section_len(array)) return LSML_ERR_NOT_FOUND;
+    if (value) *value = lsml_array_value(array, index);
     return LSML_OK;
 }
 
 lsml_err_t lsml_array_get_2d(const lsml_section_t *array, size_t row, size_t col, lsml_string_t *value) {
     if (array == NULL) return LSML_ERR_INVALID_SECTION;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
-    lsml_rows_index_t *row_index = array->row_indices;
-    while(row) {
-        row_index = row_index->next;
-        if (row_index == NULL) return LSML_ERR_NOT_FOUND;
-        row--;
-    }
-    // row is now zero, because it was used to track iteration
-    col += row_index->index; // col is now the absolute index into the array
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    size_t start, end;
+    if (lsml_array_row_range(array, row, &start, &end)) return LSML_ERR_NOT_FOUND;
     // check if the column would go into the next row, if so fail
-    if (row_index->next && col >= row_index->next->index) return LSML_ERR_NOT_FOUND;
-    lsml_string_t *elem = (lsml_string_t *) lsml_cha_get(array->section.array, array->n_elems, array->n_chunks, col);
-    if (value) *value = *elem;
+    if (col >= end - start) return LSML_ERR_NOT_FOUND;
+    col += start; // col is now the absolute index into the array
+    if (value) *value = lsml_array_value(array, col);
     return LSML_OK;
 }
 
+// Finds the first element equal to value in [start, end) of an array, setting *index to its index.
+static int lsml_array_find_range(const lsml_section_t *array, const lsml_string_t *value, size_t start, size_t end, size_t *index) {
+    if (lsml_section_frozen(array)) {
+        for (size_t i = start; i < end; i++) {
+            lsml_string_t elem = lsml_frozen_value(lsml_frozen_section(array), i);
+            if (lsml_string_eq(&elem, value)) {
+                *index = i;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    for (size_t i = start; i < end; i++) {
+        if (lsml_string_eq(lsml_array_elem(array, i), value)) {
+            *index = i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+lsml_err_t lsml_array_find(const lsml_section_t *array, const char *value, size_t value_len, size_t *index) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    if (value == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_string_t string = lsml_string_init(value, value_len);
+    size_t i;
+    if (!lsml_array_find_range(array, &string, 0, lsml_section_len(array), &i)) return LSML_ERR_NOT_FOUND;
+    if (index) *index = i;
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_find_2d(const lsml_section_t *array, const char *value, size_t value_len, size_t *row, size_t *col) {
+    size_t i;
+    lsml_err_t err = lsml_array_find(array, value, value_len, &i);
+    if (err) return err;
+    size_t r = lsml_array_row_of(array, i);
+    if (row) *row = r;
+    if (col) *col = i - lsml_array_row_start(array, r);
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_find_in_row(const lsml_section_t *array, const char *value, size_t value_len, size_t row, size_t *col) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    if (value == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_string_t string = lsml_string_init(value, value_len);
+    size_t start, end, i;
+    if (lsml_array_row_range(array, row, &start, &end)) return LSML_ERR_NOT_FOUND;
+    if (!lsml_array_find_range(array, &string, start, end, &i)) return LSML_ERR_NOT_FOUND;
+    if (col) *col = i - start;
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_find_in_col(const lsml_section_t *array, const char *value, size_t value_len, size_t *row, size_t col) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    if (value == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_string_t string = lsml_string_init(value, value_len);
+    size_t n_rows = lsml_array_n_rows(array);
+    for (size_t r = 0; r < n_rows; r++) {
+        size_t start, end, i;
+        if (lsml_array_row_range(array, r, &start, &end)) break;
+        if (col < end - start && lsml_array_find_range(array, &string, start + col, start + col + 1, &i)) {
+            if (row) *row = r;
+            return LSML_OK;
+        }
+    }
+    return LSML_ERR_NOT_FOUND;
+}
+
+// Copies the values in [start, start+n) of an array, a chunk at a time.
+static void lsml_array_copy_range(const lsml_section_t *array, size_t start, size_t n, lsml_string_t *values) {
+    if (n == 0) return;
+    if (lsml_section_frozen(array)) {
+        // a frozen array's values are one after another, so they are only turned into descriptors
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(array);
+        const char *base = lsml_frozen_base(frozen);
+        const lsml_frozen_str_t *elems = (const lsml_frozen_str_t *) (base + frozen->elems) + start;
+        for (size_t i = 0; i < n; i++) values[i] = lsml_frozen_string(base, elems[i]);
+        return;
+    }
+    size_t chunk = start / LSML_ARRAY_CHUNK_LEN;
+    size_t chunk_index = start % LSML_ARRAY_CHUNK_LEN;
+    const lsml_array_chunk_t *cha = array->array_dir ? array->array_dir[chunk] : array->section.array;
+    while (n) {
+        size_t n_copy = LSML_ARRAY_CHUNK_LEN - chunk_index;
+        if (n_copy > n) n_copy = n;
+        memcpy(values, cha->elems + chunk_index, n_copy*sizeof(lsml_string_t));
+        values += n_copy;
+        n -= n_copy;
+        chunk_index = 0;
+        cha = cha->next;
+    }
+}
+
 lsml_err_t lsml_array_get_many(const lsml_section_t *array, size_t start_index, size_t n_elems, lsml_string_t *values) {
     if (array == NULL) return LSML_ERR_INVALID_SECTION;
     // if (array->type != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
-    if (start_index >= array->n_elems || (start_index+n_elems) > array->n_elems) return LSML_ERR_NOT_FOUND;
-    lsml_iter_t array_iter = {0};
-    lsml_string_t *value = NULL;
-    size_t i = 0, n = start_index+n_elems;
-    while(lsml_array_next(array, &array_iter, value)) {
-        if (i >= start_index && i < n) {
-            values[i - start_index] = *value;
-        }
-        i += 1;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    size_t array_elems = lsml_section_len(array);
+    if (start_index >= array_elems || (start_index+n_elems) > array_elems) return LSML_ERR_NOT_FOUND;
+    if (values) lsml_array_copy_range(array, start_index, n_elems, values);
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_get_rows(const lsml_section_t *array, size_t start_row, size_t n_rows, lsml_array_span_t *spans, lsml_string_t *values, size_t n_values, size_t *n_values_avail) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    size_t array_rows = lsml_section_len(array) ? lsml_array_n_rows(array) : 0;
+    if (start_row >= array_rows || n_rows > array_rows - start_row) return LSML_ERR_NOT_FOUND;
+    size_t start, end, row_end;
+    lsml_array_row_range(array, start_row, &start, &end);
+    if (n_rows == 0) end = start;
+    else lsml_array_row_range(array, start_row + n_rows - 1, &row_end, &end);
+    for (size_t i = 0; spans && i < n_rows; i++) {
+        lsml_array_row_range(array, start_row + i, &spans[i].start, &row_end);
+        spans[i].len = row_end - spans[i].start;
     }
+    if (values) lsml_array_copy_range(array, start, n_values < end - start ? n_values : end - start, values);
+    if (n_values_avail) *n_values_avail = end - start;
     return LSML_OK;
 }
 
 lsml_err_t lsml_array_push(lsml_data_t *data, lsml_section_t *array, const char *val, size_t val_len, int newrow) {
-    if (data == NULL) return LSML_ERR_INVALID_DATA;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
     if (!lsml_data_owns_ptr(data, array)) return LSML_ERR_INVALID_SECTION;
-    if (array->row_indices == NULL) return LSML_ERR_SECTION_TYPE;
+    if (array->row_starts == NULL) return LSML_ERR_SECTION_TYPE;
     if (val == NULL) return LSML_ERR_VALUE_NULL;
-    lsml_reg_str_t *val_reg;
+    lsml_string_t string = lsml_string_init(val, val_len);
+    lsml_string_t value;
     lsml_err_t err;
-    err = lsml_data_register_string(data, val, val_len, 0, &val_reg);
+    err = lsml_array_store_value(data, array, &string, 0, &value);
+    if (err) return err;
+    return lsml_array_add_entry_internal(data, array, &value, newrow);
+}
+
+// Gives back the bytes of a value which an array stored on its own, unless they are in the source it was parsed in place from.
+static void lsml_array_free_value(lsml_data_t *data, const lsml_section_t *array, const lsml_string_t *value) {
+    if (array->uninterned && lsml_data_owns_ptr(data, value->str)) {
+        lsml_bump_free_string(&data->alloc, (char *) value->str, value->len + 1);
+    }
+}
+
+lsml_err_t lsml_array_set(lsml_data_t *data, lsml_section_t *array, size_t index, const char *val, size_t val_len) {
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (!lsml_data_owns_ptr(data, array)) return LSML_ERR_INVALID_SECTION;
+    if (array->row_starts == NULL) return LSML_ERR_SECTION_TYPE;
+    if (val == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_string_t *elem = (lsml_string_t *) lsml_array_elem(array, index);
+    if (elem == NULL) return LSML_ERR_NOT_FOUND;
+    lsml_string_t string = lsml_string_init(val, val_len);
+    lsml_string_t value;
+    lsml_err_t err = lsml_array_store_value(data, array, &string, 0, &value);
     if (err) return err;
-    return lsml_array_add_entry_internal(data, array, &val_reg->string, newrow);
+    lsml_array_free_value(data, array, elem);
+    *elem = value;
+    return LSML_OK;
+}
+
+// Counts the rows of each width before the last row of an array, leaving them uncounted if there isn't room.
+static void lsml_array_count_widths(lsml_data_t *data, lsml_section_t *array) {
+    size_t cap = 8;
+    while (array->n_rows > 1 && cap <= array->max_cols) cap *= 2;
+    size_t *width_rows = (size_t *) lsml_bump_alloc(&data->alloc, cap*sizeof(size_t), LSML_ALIGNOF(size_t));
+    if (width_rows == NULL) return;
+    memset(width_rows, 0, cap*sizeof(size_t));
+    for (size_t r = 0; r + 1 < array->n_rows; r++) width_rows[array->row_starts[r + 1] - array->row_starts[r]] += 1;
+    array->width_rows = width_rows;
+    array->width_cap = cap;
+}
+
+// Takes a row of some width out of the rows before the last row of an array, finding their fewest and most columns again.
+static void lsml_array_uncount_row(lsml_section_t *array, size_t cols) {
+    if (array->width_rows == NULL) {
+        // no counts, so every row is looked at
+        array->min_cols = (size_t) -1;
+        array->max_cols = 0;
+        for (size_t r = 0; r + 1 < array->n_rows; r++) {
+            size_t width = array->row_starts[r + 1] - array->row_starts[r];
+            if (width < array->min_cols) array->min_cols = width;
+            if (width > array->max_cols) array->max_cols = width;
+        }
+        return;
+    }
+    array->width_rows[cols] -= 1;
+    if (array->width_rows[cols] > 0) return;
+    if (array->min_cols == array->max_cols) {
+        // that was the last of them
+        array->min_cols = (size_t) -1;
+        array->max_cols = 0;
+    } else if (cols == array->min_cols) {
+        while (array->width_rows[array->min_cols] == 0) array->min_cols += 1;
+    } else if (cols == array->max_cols) {
+        while (array->width_rows[array->max_cols] == 0) array->max_cols -= 1;
+    }
+}
+
+lsml_err_t lsml_array_remove_row(lsml_data_t *data, lsml_section_t *array, size_t row) {
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (!lsml_data_owns_ptr(data, array)) return LSML_ERR_INVALID_SECTION;
+    if (array->row_starts == NULL) return LSML_ERR_SECTION_TYPE;
+    size_t start, end;
+    if (lsml_array_row_range(array, row, &start, &end)) return LSML_ERR_NOT_FOUND;
+    // without room for the counts, the rows are looked at again instead
+    if (array->width_rows == NULL) lsml_array_count_widths(data, array);
+    size_t n_removed = end - start;
+    for (size_t i = start; i < end; i++) lsml_array_free_value(data, array, lsml_array_elem(array, i));
+    // later values move back, since values are found by their index
+    for (size_t i = end; i < array->n_elems; i++) {
+        *(lsml_string_t *) lsml_array_elem(array, i - n_removed) = *lsml_array_elem(array, i);
+    }
+    array->n_elems -= n_removed;
+    if (array->n_elems == 0) {
+        // the array is empty again, like a new one
+        if (array->width_rows) memset(array->width_rows, 0, array->width_cap*sizeof(size_t));
+        array->n_rows = 1;
+        array->min_cols = (size_t) -1;
+        array->max_cols = 0;
+    } else if (row + 1 < array->n_rows) {
+        for (size_t r = row; r + 1 < array->n_rows; r++) array->row_starts[r] = array->row_starts[r + 1] - n_removed;
+        array->n_rows -= 1;
+        lsml_array_uncount_row(array, n_removed);
+    } else {
+        // the row before becomes the last row
+        array->n_rows -= 1;
+        lsml_array_uncount_row(array, array->n_elems - array->row_starts[array->n_rows - 1]);
+    }
+    // chunks past the last value are kept, linked after the last chunk, for values pushed later
+    size_t n_chunks = (array->n_elems + LSML_ARRAY_CHUNK_LEN - 1) / LSML_ARRAY_CHUNK_LEN;
+    if (n_chunks == 0) n_chunks = 1;
+    array->n_chunks = n_chunks;
+    array->last_chunk = array->array_dir ? array->array_dir[n_chunks - 1] : array->section.array;
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_set_interning(lsml_section_t *array, int intern) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    // a frozen array can't be changed, and every value of an array is stored the same way
+    if (lsml_section_frozen(array)) return LSML_ERR_INVALID_SECTION;
+    if (array->n_elems != 0) return LSML_ERR_INVALID_SECTION;
+    array->uninterned = !intern;
+    return LSML_OK;
+}
+
+lsml_err_t lsml_array_intern_stats(const lsml_section_t *array, size_t *n_interned, size_t *n_reused) {
+    if (array == NULL) return LSML_ERR_INVALID_SECTION;
+    if (lsml_section_type(array) != LSML_ARRAY) return LSML_ERR_SECTION_TYPE;
+    if (lsml_section_frozen(array)) {
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(array);
+        if (n_interned) *n_interned = frozen->n_interned;
+        if (n_reused) *n_reused = frozen->n_reused;
+        return LSML_OK;
+    }
+    if (n_interned) *n_interned = array->n_interned;
+    if (n_reused) *n_reused = array->n_reused;
+    return LSML_OK;
 }
 
 int lsml_array_next(const lsml_section_t *array, lsml_iter_t *iter, lsml_string_t *value) {
     // if (array == NULL || iter == NULL || array->section.array == NULL || array->type != LSML_ARRAY) return 0;
-    if (array == NULL || iter == NULL || array->section.array == NULL || array->row_indices == NULL) return 0;
+    if (array == NULL || iter == NULL || lsml_section_type(array) != LSML_ARRAY) return 0;
+    if (lsml_section_frozen(array)) return lsml_array_next_2d(array, iter, value, NULL, NULL);
+    if (array->section.array == NULL) return 0;
     if (iter->chunk == NULL) {
         iter->chunk = array->section.array;
-        iter->elem = array->section.array->elems[0];
+        iter->elem = array->section.array->elems;
         iter->index = 0;
     } else { // try to go to next element
         iter->index += 1;
-        size_t index_wrapped = lsml_mod_chunklen(iter->index, LSML_CHUNK_LEN);
+        size_t index_wrapped = lsml_mod_chunklen(iter->index, LSML_ARRAY_CHUNK_LEN);
         if (index_wrapped == 0) {
             void *next_chunk = ((lsml_array_chunk_t *) iter->chunk)->next;
             if (next_chunk) {
@@ -928,7 +2115,7 @@ int lsml_array_next(const lsml_section_t *array, lsml_iter_t *iter, lsml_string_
                 return 0;
             }
         }
-        iter->elem = ((lsml_array_chunk_t *) iter->chunk)->elems[index_wrapped];
+        iter->elem = ((lsml_array_chunk_t *) iter->chunk)->elems + index_wrapped;
     }
     if (iter->index >= array->n_elems) return 0;
     if (value) *value = *((lsml_string_t *)iter->elem);
@@ -936,18 +2123,35 @@ int lsml_array_next(const lsml_section_t *array, lsml_iter_t *iter, lsml_string_
 }
 
 int lsml_array_next_2d(const lsml_section_t *array, lsml_iter_t *iter, lsml_string_t *value, size_t *row, size_t *col) {
-    lsml_string_t *string = NULL;
-    if (array == NULL || iter == NULL || array->section.array == NULL || array->row_indices == NULL) return 0;
+    const lsml_string_t *string = NULL;
+    if (array == NULL || iter == NULL || lsml_section_type(array) != LSML_ARRAY) return 0;
+    if (lsml_section_frozen(array)) {
+        // a frozen array's values are one after another, so iter->chunk only marks that iteration started
+        const lsml_frozen_section_t *frozen = lsml_frozen_section(array);
+        const uint32_t *row_starts = lsml_frozen_row_starts(frozen);
+        if (iter->chunk == NULL) {
+            iter->chunk = (void *) array;
+            iter->index = 0;
+            iter->row = 0;
+        } else if (iter->index < frozen->n_elems) {
+            iter->index += 1;
+        }
+        if (iter->index >= frozen->n_elems) return 0;
+        while (iter->row + 1 < frozen->n_rows && iter->index >= row_starts[iter->row + 1]) iter->row += 1;
+        if (value) *value = lsml_frozen_value(frozen, iter->index);
+        if (row) *row = iter->row;
+        if (col) *col = iter->index - row_starts[iter->row];
+        return 1;
+    }
+    if (array->section.array == NULL) return 0;
     if (iter->chunk == NULL) {
         iter->chunk = array->section.array;
-        iter->elem = array->row_indices->next; // NOT an element, instead the NEXT row start
         iter->index = 0;
-        string = array->section.array->elems[0];
-        if (row) *row = 0;
-        if (col) *col = 0;
+        iter->row = 0;
+        string = array->section.array->elems;
     } else { // try to go to next element
         iter->index += 1;
-        size_t index_wrapped = lsml_mod_chunklen(iter->index, LSML_CHUNK_LEN);
+        size_t index_wrapped = lsml_mod_chunklen(iter->index, LSML_ARRAY_CHUNK_LEN);
         if (index_wrapped == 0) {
             void *next_chunk = ((lsml_array_chunk_t *) iter->chunk)->next;
             if (next_chunk) {
@@ -957,30 +2161,734 @@ int lsml_array_next_2d(const lsml_section_t *array, lsml_iter_t *iter, lsml_stri
                 return 0;
             }
         }
-        string = ((lsml_array_chunk_t *) iter->chunk)->elems[index_wrapped];
-        // if the chunk index is the same index as the NEXT row start index
-        if (iter->elem && iter->index == ((lsml_rows_index_t*)iter->elem)->index) {
-            if (row) *row += 1;
-            if (col) *col = 0;
-            iter->elem = ((lsml_rows_index_t*)iter->elem)->next;
-        } else {
-            if (col) *col += 1; // then we advance the column
-        }
+        string = ((lsml_array_chunk_t *) iter->chunk)->elems + index_wrapped;
+        // if the index is the start of the next row
+        if (iter->row + 1 < array->n_rows && iter->index == array->row_starts[iter->row + 1]) iter->row += 1;
     }
     if (iter->index >= array->n_elems) return 0;
+    iter->elem = (void *) string;
     if (value) *value = *string;
+    if (row) *row = iter->row;
+    if (col) *col = iter->index - array->row_starts[iter->row];
     return 1;
 }
 
 
 
-// --- IO
+// --- Copying
+//
+// Each string of the source is registered with the destination the first time it is used, and a temporary map
+// from the source's strings to the destination's finds it again for its other uses, without hashing it.
+// Values only hold the descriptors of their strings, so the map is keyed by the pointer to a string's bytes.
+// The map is allocated by a growable data's allocator, or taken from the end of a fixed data's free memory,
+// in which case it is given back if the copy runs out of memory, and the copy goes on without it.
+
+typedef struct lsml_copy_entry_t {
+    const char *src; // NULL if the slot is empty
+    lsml_reg_str_t *dst;
+} lsml_copy_entry_t;
+
+typedef struct lsml_copy_t {
+    lsml_data_t *dest;
+    lsml_copy_entry_t *map; // NULL if there is no map
+    size_t cap; // a power of 2, at least twice the number of strings mapped
+    size_t n_mapped;
+    size_t map_size; // bytes of the map
+    size_t og_size; // size of a fixed data's memory before the map was taken from it
+} lsml_copy_t;
+
+// Makes a map with room for n_strings strings, or none if there is no memory for it.
+static void lsml_copy_map_init(lsml_copy_t *copy, size_t n_strings) {
+    lsml_bump_alloc_t *alloc = &copy->dest->alloc;
+    size_t cap = LSML_OA_GROUP_LEN;
+    while (cap < 2*n_strings) cap *= 2;
+    size_t size = cap*sizeof(lsml_copy_entry_t);
+    if (n_strings == 0 || size/sizeof(lsml_copy_entry_t) != cap) return;
+    copy->map = (lsml_copy_entry_t *) lsml_bump_take_scratch(alloc, size, LSML_ALIGNOF(lsml_copy_entry_t), &copy->og_size);
+    if (copy->map == NULL) return;
+    memset(copy->map, 0, size);
+    copy->cap = cap;
+    copy->map_size = size;
+}
+
+// Gives back the memory of the map, returning nonzero if there was one.
+static int lsml_copy_map_free(lsml_copy_t *copy) {
+    lsml_bump_alloc_t *alloc = &copy->dest->alloc;
+    if (copy->map == NULL) return 0;
+    lsml_bump_give_back_scratch(alloc, copy->map, copy->map_size, copy->og_size);
+    copy->map = NULL;
+    return 1;
+}
 
+// Gets the destination's registered string for one of the source's strings, registering it the first time.
+static lsml_err_t lsml_copy_string(lsml_copy_t *copy, const lsml_string_t *string, lsml_reg_str_t **reg_str) {
+    lsml_copy_entry_t *slot = NULL;
+    if (copy->map) {
+        size_t mask = copy->cap - 1;
+        size_t index = (size_t) lsml_wymix((uint64_t) (uintptr_t) string->str, lsml_wyp[0]) & mask;
+        while (copy->map[index].src && copy->map[index].src != string->str) index = (index + 1) & mask;
+        slot = copy->map + index;
+        if (slot->src && slot->dst->string.len == string->len) {
+            *reg_str = slot->dst;
+            return LSML_OK;
+        }
+        // strings which share their bytes with another are registered without being mapped, as are any past the map's load factor
+        if (slot->src || 2*(copy->n_mapped + 1) > copy->cap) slot = NULL;
+    }
+    // an empty string's pointer may be past the end of its source, so it isn't read
+    lsml_err_t err = lsml_data_register_string(copy->dest, string->len ? string->str : "", string->len, 0, reg_str);
+    if (err) return err;
+    if (slot) {
+        slot->src = string->str;
+        slot->dst = *reg_str;
+        copy->n_mapped += 1;
+    }
+    return LSML_OK;
+}
 
-static int lsml_getc(lsml_reader_t reader) {
-    return reader.read(reader.userdata);
+// Finds or creates the destination's section for a section of the source.
+// dst is set to NULL if the source's section is ignored, and is emptied first if the source's section replaces it.
+static lsml_err_t lsml_copy_section(lsml_copy_t *copy, const lsml_section_t *section, lsml_section_type_t type, int overwrite_conflicts, lsml_section_t **dst) {
+    lsml_data_t *data = copy->dest;
+    lsml_reg_str_t *name;
+    lsml_section_t *found;
+    lsml_string_t src_name;
+    *dst = NULL;
+    lsml_section_info(section, &src_name, NULL, NULL);
+    // the source may be frozen, so how it stores its values is read like its name
+    int uninterned = lsml_section_frozen(section) ? (int) lsml_frozen_section(section)->uninterned : section->uninterned;
+    lsml_err_t err = lsml_copy_string(copy, &src_name, &name);
+    if (err) return err;
+    err = lsml_data_add_section_internal(data, name, type, &found);
+    if (err == LSML_OK) {
+        found->uninterned = uninterned;
+        *dst = found;
+        return LSML_OK;
+    }
+    if (err != LSML_ERR_SECTION_NAME_REUSED) return err;
+    found = (lsml_section_t *) lsml_hm_get_node(data->sections_head, (void **) data->sections_dir, data->n_section_chunks, &name->string, data->hash_seed);
+    if (type == LSML_TABLE && found->row_starts == NULL) {
+        // tables are merged key by key
+        if (found->lazy_body) lsml_section_load(data, found);
+        *dst = found;
+        return LSML_OK;
+    }
+    if (!overwrite_conflicts) return LSML_OK;
+    size_t *row_starts = NULL;
+    if (type == LSML_ARRAY) {
+        row_starts = (size_t *) lsml_bump_alloc(&data->alloc, sizeof(size_t), LSML_ALIGNOF(size_t));
+        if (row_starts == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    }
+    lsml_section_init(data, found, row_starts);
+    found->uninterned = uninterned;
+    *dst = found;
+    return LSML_OK;
 }
 
+static lsml_err_t lsml_copy_table_entry(lsml_copy_t *copy, lsml_section_t *table, const lsml_string_t *key, const lsml_string_t *value, int overwrite_conflicts) {
+    lsml_reg_str_t *dst_key, *dst_value;
+    lsml_err_t err = lsml_copy_string(copy, key, &dst_key);
+    if (err) return err;
+    lsml_table_entry_t *entry = (lsml_table_entry_t *) lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), dst_key->hash, NULL, dst_key);
+    if (entry && !overwrite_conflicts) return LSML_OK;
+    err = lsml_copy_string(copy, value, &dst_value);
+    if (err) return err;
+    if (entry) {
+        entry->value = dst_value->string;
+        return LSML_OK;
+    }
+    return lsml_table_add_entry_internal(copy->dest, table, dst_key, dst_value);
+}
+
+static lsml_err_t lsml_copy_array_value(lsml_copy_t *copy, lsml_section_t *array, const lsml_string_t *value, int newrow) {
+    lsml_string_t stored;
+    lsml_err_t err;
+    int reused = 0;
+    if (array->uninterned) {
+        lsml_string_t string = *value;
+        err = lsml_array_store_value(copy->dest, array, &string, 0, &stored);
+    } else {
+        size_t n_strings = copy->dest->n_strings;
+        lsml_reg_str_t *reg_str;
+        err = lsml_copy_string(copy, value, &reg_str);
+        if (err == LSML_OK) stored = reg_str->string;
+        reused = copy->dest->n_strings == n_strings;
+    }
+    if (err) return err;
+    err = lsml_array_add_entry_internal(copy->dest, array, &stored, newrow);
+    if (err) return err;
+    if (!array->uninterned) {
+        array->n_interned += 1;
+        array->n_reused += (size_t) reused;
+    }
+    return LSML_OK;
+}
+
+// Copies src into dest like lsml_data_copy, with a map made for n_strings of src's strings.
+static lsml_err_t lsml_copy_data(lsml_data_t *dest, const lsml_data_t *src, int overwrite_conflicts, size_t n_strings) {
+    if (dest == NULL || src == NULL || dest->frozen) return LSML_ERR_INVALID_DATA;
+    if (dest == src) return LSML_OK;
+    lsml_copy_t copy = {0};
+    copy.dest = dest;
+    lsml_copy_map_init(&copy, n_strings);
+    lsml_iter_t section_iter = {0};
+    lsml_section_t *section, *dst;
+    lsml_section_type_t section_type;
+    lsml_string_t key, value;
+    lsml_err_t err = LSML_OK;
+    // anything which runs out of memory with the map is tried again without it
+    while (!err && lsml_data_next_section(src, &section_iter, &section, &section_type)) {
+        lsml_iter_t values_iter = {0};
+        err = lsml_copy_section(&copy, section, section_type, overwrite_conflicts, &dst);
+        if (err == LSML_ERR_OUT_OF_MEMORY && lsml_copy_map_free(&copy)) err = lsml_copy_section(&copy, section, section_type, overwrite_conflicts, &dst);
+        if (err || dst == NULL) continue;
+        if (section_type == LSML_TABLE) {
+            // the table needs room for at least as many keys as the larger of the two, which is all of them if either has every key
+            // If making room fails even without the map, the table grows as entries are added instead.
+            if (lsml_section_len(section) > dst->n_elems) {
+                size_t n_more = lsml_section_len(section) - dst->n_elems;
+                if (lsml_table_reserve(dest, dst, n_more) == LSML_ERR_OUT_OF_MEMORY && lsml_copy_map_free(&copy)) lsml_table_reserve(dest, dst, n_more);
+            }
+            while (!err && lsml_table_next(section, &values_iter, &key, &value)) {
+                err = lsml_copy_table_entry(&copy, dst, &key, &value, overwrite_conflicts);
+                if (err == LSML_ERR_OUT_OF_MEMORY && lsml_copy_map_free(&copy)) err = lsml_copy_table_entry(&copy, dst, &key, &value, overwrite_conflicts);
+            }
+        } else {
+            size_t row, col;
+            while (!err && lsml_array_next_2d(section, &values_iter, &value, &row, &col)) {
+                err = lsml_copy_array_value(&copy, dst, &value, col == 0);
+                if (err == LSML_ERR_OUT_OF_MEMORY && lsml_copy_map_free(&copy)) err = lsml_copy_array_value(&copy, dst, &value, col == 0);
+            }
+        }
+    }
+    lsml_copy_map_free(&copy);
+    return err;
+}
+
+lsml_err_t lsml_data_copy(lsml_data_t *dest, const lsml_data_t *src, int overwrite_conflicts) {
+    return lsml_copy_data(dest, src, overwrite_conflicts, src ? src->n_strings : 0);
+}
+
+// --- Freezing
+//
+// A frozen data is rebuilt from another data in exactly as much memory as it needs, and can't be changed.
+// - Sections are stored one after another, in the order of a minimal perfect hash of their names.
+// - Strings are stored one after another, without the strings hashmap.
+// - Table entries fill exactly as many slots as there are entries, in the order of a minimal perfect hash of their keys.
+// - Sections and table entries keep the order they were added in, which is how they are iterated.
+// - Arrays store their values one after another.
+// Each minimal perfect hash is built in the memory its sections or entries are copied into afterwards.
+//
+// Nothing in a frozen data points anywhere: the data starts its memory, and everything else in it is found
+// by a 32 bit offset from the data, so the memory reads the same wherever it is copied or mapped.
+// Strings are described by their offset and length, and turned into lsml_string_t as they are read.
+//
+// The strings are in the order of the source's strings hashmap, so the copy of a string is found
+// by binary searching for the slot it is in. While sections are copied, the copies' lengths hold these slots.
+
+static void lsml_freeze_count(size_t *offset, size_t size, size_t align) {
+    *offset = ((*offset + (align-1)) & ~(align-1)) + size;
+}
+
+// Gets the offset from a frozen data of something in its memory.
+static uint32_t lsml_freeze_offset(const lsml_data_t *data, const void *ptr) {
+    return (uint32_t) ((const char *) ptr - (const char *) data);
+}
+
+// Parses every lazy section of the source, since a frozen data can't parse them later.
+static void lsml_freeze_load_all(const lsml_data_t *src) {
+    lsml_iter_t iter = {0};
+    lsml_section_t *section;
+    while (lsml_data_next_section(src, &iter, &section, NULL));
+}
+
+// Finds the copy of one of the source's registered strings.
+static lsml_frozen_str_t lsml_freeze_string(const lsml_data_t *src, const lsml_frozen_str_t *strings, size_t n_strings, const lsml_reg_str_t *str) {
+    lsml_oa_entry_t *entry = lsml_oa_find(&src->strings, sizeof(lsml_oa_entry_t), str->hash, NULL, str);
+    size_t slot = (size_t) (entry - (lsml_oa_entry_t *) src->strings.slots);
+    size_t lo = 0, hi = n_strings;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo)/2;
+        if ((size_t) strings[mid].len < slot) lo = mid + 1;
+        else hi = mid;
+    }
+    lsml_frozen_str_t copy;
+    copy.off = strings[lo].off;
+    copy.len = (uint32_t) str->string.len;
+    return copy;
+}
+
+// Finds the copy of a value, which is one of the source's registered strings.
+// Values only hold the descriptor of their registered string, so it is found again by hashing the value.
+static lsml_frozen_str_t lsml_freeze_value(const lsml_data_t *src, const lsml_frozen_str_t *strings, size_t n_strings, const lsml_string_t *value) {
+    lsml_hash_t hash = lsml_hash_string(value, src->hash_seed);
+    lsml_oa_entry_t *entry = lsml_oa_find(&src->strings, sizeof(lsml_oa_entry_t), hash, value, NULL);
+    return lsml_freeze_string(src, strings, n_strings, entry->str);
+}
+
+size_t lsml_data_freeze_size(const lsml_data_t *src) {
+    if (src == NULL || src->frozen) return 0;
+    lsml_freeze_load_all(src);
+    size_t offset = 0, n_bytes = 0;
+    lsml_freeze_count(&offset, sizeof(lsml_data_t), LSML_ALIGNOF(lsml_data_t));
+    lsml_freeze_count(&offset, lsml_mph_n_buckets(src->n_sections)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+    lsml_freeze_count(&offset, src->n_sections*sizeof(lsml_frozen_section_t), LSML_ALIGNOF(lsml_frozen_section_t));
+    lsml_freeze_count(&offset, src->n_strings*sizeof(lsml_frozen_str_t), LSML_ALIGNOF(lsml_frozen_str_t));
+    for (size_t i = 0; i < src->strings.cap; i++) {
+        if (src->strings.ctrl[i] & LSML_OA_EMPTY) continue;
+        n_bytes += lsml_oa_slot(&src->strings, sizeof(lsml_oa_entry_t), i)->str->string.len + 1;
+    }
+    lsml_freeze_count(&offset, n_bytes, LSML_ALIGNOF(char));
+    lsml_iter_t iter = {0};
+    lsml_section_t *section;
+    lsml_section_type_t type;
+    while (lsml_data_next_section(src, &iter, &section, &type)) {
+        if (type == LSML_TABLE) {
+            if (section->n_elems == 0) continue;
+            lsml_freeze_count(&offset, lsml_mph_n_buckets(section->n_elems)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+            lsml_freeze_count(&offset, section->n_elems*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+            lsml_freeze_count(&offset, section->n_elems*sizeof(lsml_frozen_entry_t), LSML_ALIGNOF(lsml_frozen_entry_t));
+        } else {
+            lsml_freeze_count(&offset, section->n_rows*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+            lsml_freeze_count(&offset, section->n_elems*sizeof(lsml_frozen_str_t), LSML_ALIGNOF(lsml_frozen_str_t));
+            if (section->uninterned) {
+                lsml_iter_t values_iter = {0};
+                lsml_string_t value;
+                size_t n_value_bytes = 0;
+                while (lsml_array_next(section, &values_iter, &value)) n_value_bytes += value.len + 1;
+                lsml_freeze_count(&offset, n_value_bytes, LSML_ALIGNOF(char));
+            }
+        }
+    }
+    // every offset must fit in 32 bits
+    if (offset > (size_t) UINT32_MAX) return 0;
+    // the bump allocator never fills the last byte
+    return offset + 1;
+}
+
+// Copies a table into a frozen data, whose strings are being copied.
+// Returns INVALID_DATA if no minimal perfect hash can be built for its keys.
+static lsml_err_t lsml_freeze_table(lsml_data_t *data, const lsml_data_t *src, const lsml_frozen_str_t *strings, lsml_frozen_section_t *dst, const lsml_section_t *table) {
+    size_t n_elems = table->n_elems;
+    if (n_elems == 0) return LSML_OK;
+    // pilots go first, so every section's memory starts and ends aligned, and the size doesn't depend on their order
+    lsml_mph_t mph;
+    mph.pilots = (uint32_t *) lsml_bump_alloc(&data->alloc, lsml_mph_n_buckets(n_elems)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+    uint32_t *order = (uint32_t *) lsml_bump_alloc(&data->alloc, n_elems*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+    lsml_frozen_entry_t *entries = (lsml_frozen_entry_t *) lsml_bump_alloc(&data->alloc, n_elems*sizeof(lsml_frozen_entry_t), LSML_ALIGNOF(lsml_frozen_entry_t));
+    if (entries == NULL || order == NULL || mph.pilots == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    const lsml_oa_t *oa = &table->section.table;
+    lsml_hash_t *hashes = (lsml_hash_t *) entries;
+    size_t position = 0;
+    for (size_t i = 0; i < n_elems; i++) {
+        hashes[i] = lsml_oa_next(oa, n_elems, sizeof(lsml_table_entry_t), &position)->hash;
+    }
+    if (lsml_mph_build(&mph, entries, n_elems)) return LSML_ERR_INVALID_DATA;
+    position = 0;
+    for (size_t i = 0; i < n_elems; i++) {
+        const lsml_table_entry_t *entry = (const lsml_table_entry_t *) lsml_oa_next(oa, n_elems, sizeof(lsml_table_entry_t), &position);
+        order[i] = (uint32_t) lsml_mph_index(&mph, entry->entry.hash, n_elems);
+        lsml_frozen_entry_t *copy = entries + order[i];
+        copy->hash = entry->entry.hash;
+        copy->key = lsml_freeze_string(src, strings, data->n_strings, entry->entry.str);
+        copy->value = lsml_freeze_value(src, strings, data->n_strings, &entry->value);
+    }
+    dst->elems = lsml_freeze_offset(data, entries);
+    dst->order = lsml_freeze_offset(data, order);
+    dst->pilots = lsml_freeze_offset(data, mph.pilots);
+    dst->n_buckets = (uint32_t) mph.n_buckets;
+    dst->n_elems = (uint32_t) n_elems;
+    return LSML_OK;
+}
+
+// Copies an array into a frozen data, whose strings are being copied.
+static lsml_err_t lsml_freeze_array(lsml_data_t *data, const lsml_data_t *src, const lsml_frozen_str_t *strings, lsml_frozen_section_t *dst, const lsml_section_t *array) {
+    uint32_t *row_starts = (uint32_t *) lsml_bump_alloc(&data->alloc, array->n_rows*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+    lsml_frozen_str_t *values = (lsml_frozen_str_t *) lsml_bump_alloc(&data->alloc, array->n_elems*sizeof(lsml_frozen_str_t), LSML_ALIGNOF(lsml_frozen_str_t));
+    if (row_starts == NULL || values == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    for (size_t i = 0; i < array->n_rows; i++) row_starts[i] = (uint32_t) array->row_starts[i];
+    dst->is_array = 1;
+    dst->elems = lsml_freeze_offset(data, values);
+    dst->order = lsml_freeze_offset(data, row_starts);
+    dst->n_elems = (uint32_t) array->n_elems;
+    dst->n_rows = (uint32_t) array->n_rows;
+    dst->min_cols = array->min_cols == SIZE_MAX ? UINT32_MAX : (uint32_t) array->min_cols;
+    dst->max_cols = (uint32_t) array->max_cols;
+    dst->uninterned = (uint32_t) array->uninterned;
+    dst->n_interned = (uint64_t) array->n_interned;
+    dst->n_reused = (uint64_t) array->n_reused;
+    lsml_iter_t iter = {0};
+    lsml_string_t value;
+    char *bytes = NULL;
+    if (array->uninterned) {
+        // values stored on their own are copied one after another, since they aren't among the data's strings
+        size_t n_bytes = 0;
+        while (lsml_array_next(array, &iter, &value)) n_bytes += value.len + 1;
+        bytes = (char *) lsml_bump_alloc(&data->alloc, n_bytes, LSML_ALIGNOF(char));
+        if (bytes == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        memset(&iter, 0, sizeof iter);
+    }
+    while (lsml_array_next(array, &iter, &value)) {
+        lsml_frozen_str_t *elem = values + iter.index;
+        if (bytes) {
+            memcpy(bytes, value.str, value.len);
+            bytes[value.len] = 0;
+            elem->off = lsml_freeze_offset(data, bytes);
+            elem->len = (uint32_t) value.len;
+            bytes += value.len + 1;
+        } else {
+            *elem = lsml_freeze_value(src, strings, data->n_strings, &value);
+        }
+    }
+    return LSML_OK;
+}
+
+lsml_data_t *lsml_data_freeze(const lsml_data_t *src, void *dst_buf, size_t dst_size) {
+    if (src == NULL || src->frozen || dst_buf == NULL) return NULL;
+    size_t size = lsml_data_freeze_size(src);
+    if (size == 0 || dst_size < size) return NULL;
+    lsml_bump_alloc_t alloc = {0};
+    alloc.mem = (char *) dst_buf;
+    alloc.size = dst_size;
+    lsml_data_t *data = (lsml_data_t *) lsml_bump_alloc(&alloc, sizeof(lsml_data_t), LSML_ALIGNOF(lsml_data_t));
+    memset(data, 0, sizeof(lsml_data_t));
+    data->alloc = alloc;
+    data->hash_seed = src->hash_seed;
+    data->frozen = 1;
+
+    // sections, placed by the minimal perfect hash of their names
+    lsml_iter_t names_iter = {0}, iter = {0};
+    lsml_section_t *section;
+    lsml_section_type_t type;
+    lsml_mph_t mph;
+    mph.pilots = (uint32_t *) lsml_bump_alloc(&data->alloc, lsml_mph_n_buckets(src->n_sections)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+    lsml_frozen_section_t *sections = (lsml_frozen_section_t *) lsml_bump_alloc(&data->alloc, src->n_sections*sizeof(lsml_frozen_section_t), LSML_ALIGNOF(lsml_frozen_section_t));
+    lsml_hash_t *hashes = (lsml_hash_t *) sections;
+    while (lsml_data_next_section(src, &names_iter, &section, NULL)) hashes[data->n_sections++] = section->node.str->hash;
+    if (lsml_mph_build(&mph, sections, data->n_sections)) return NULL;
+    data->frozen_sections = lsml_freeze_offset(data, sections);
+    data->frozen_pilots = lsml_freeze_offset(data, mph.pilots);
+    data->frozen_n_buckets = (uint32_t) mph.n_buckets;
+
+    // strings, in the order of the source's strings hashmap
+    lsml_frozen_str_t *strings = (lsml_frozen_str_t *) lsml_bump_alloc(&data->alloc, src->n_strings*sizeof(lsml_frozen_str_t), LSML_ALIGNOF(lsml_frozen_str_t));
+    size_t n_bytes = 0;
+    for (size_t i = 0; i < src->strings.cap; i++) {
+        if (src->strings.ctrl[i] & LSML_OA_EMPTY) continue;
+        n_bytes += lsml_oa_slot(&src->strings, sizeof(lsml_oa_entry_t), i)->str->string.len + 1;
+    }
+    char *bytes = (char *) lsml_bump_alloc(&data->alloc, n_bytes, LSML_ALIGNOF(char));
+    for (size_t i = 0; i < src->strings.cap; i++) {
+        if (src->strings.ctrl[i] & LSML_OA_EMPTY) continue;
+        const lsml_string_t *string = &lsml_oa_slot(&src->strings, sizeof(lsml_oa_entry_t), i)->str->string;
+        memcpy(bytes, string->str, string->len);
+        bytes[string->len] = 0;
+        strings[data->n_strings].off = lsml_freeze_offset(data, bytes);
+        strings[data->n_strings].len = (uint32_t) i; // the slot, until every section is copied
+        bytes += string->len + 1;
+        data->n_strings += 1;
+    }
+    data->frozen_strings = lsml_freeze_offset(data, strings);
+
+    // sections, linked in the order they were added
+    lsml_frozen_section_t *last = NULL;
+    while (lsml_data_next_section(src, &iter, &section, &type)) {
+        lsml_frozen_section_t *dst = sections + lsml_mph_index(&mph, section->node.str->hash, data->n_sections);
+        memset(dst, 0, sizeof(lsml_frozen_section_t));
+        dst->self = lsml_freeze_offset(data, dst);
+        if (last) last->next_added = dst->self;
+        else data->frozen_first = dst->self;
+        last = dst;
+        dst->name_hash = section->node.str->hash;
+        dst->name = lsml_freeze_string(src, strings, data->n_strings, section->node.str);
+        lsml_err_t err = type == LSML_TABLE ? lsml_freeze_table(data, src, strings, dst, section) : lsml_freeze_array(data, src, strings, dst, section);
+        if (err) return NULL;
+    }
+
+    // restore the lengths of the strings
+    size_t n_strings = 0;
+    for (size_t i = 0; i < src->strings.cap; i++) {
+        if (src->strings.ctrl[i] & LSML_OA_EMPTY) continue;
+        strings[n_strings].len = (uint32_t) lsml_oa_slot(&src->strings, sizeof(lsml_oa_entry_t), i)->str->string.len;
+        n_strings += 1;
+    }
+    // the data keeps no pointer to its memory either, which starts at the data
+    data->alloc.mem = NULL;
+    return data;
+}
+
+// -- Opening Frozen Data
+// A frozen data holds no pointers, so a copy of its memory is usable as it is, wherever it is.
+
+lsml_data_t *lsml_data_relocate(void *buf, size_t size) {
+    // the data starts the copy, which must be aligned for it
+    if (buf == NULL || (uintptr_t) buf % LSML_ALIGNOF(lsml_data_t) != 0 || size < sizeof(lsml_data_t)) return NULL;
+    lsml_data_t *data = (lsml_data_t *) buf;
+    if (!data->frozen || data->alloc.size != size || data->alloc.offset > size) return NULL;
+    return data;
+}
+
+// -- Snapshots
+// A snapshot is a header followed by the whole buffer of a frozen data, which is opened where it is.
+// The header is written in the byte order and type sizes of the machine which saved it,
+// and a snapshot only opens on a build with the same ones, so nothing in it is converted.
+// The frozen data holds no pointers, so a snapshot opens wherever it is loaded or mapped, even in read-only memory.
+
+#define LSML_SNAPSHOT_VERSION 4
+#define LSML_SNAPSHOT_BYTE_ORDER 0x01020304u
+
+typedef struct lsml_snapshot_header_t {
+    char magic[8]; // "LSMLSNAP"
+    uint32_t version;
+    uint32_t byte_order; // LSML_SNAPSHOT_BYTE_ORDER, as stored by the machine which saved it
+    uint32_t type_sizes; // sizes of pointers and size_t, and the alignment of lsml_max_align_t, a byte each
+    uint32_t data_size;
+    uint32_t section_size;
+    uint32_t entry_size;
+    uint64_t image_size; // size of the frozen data's buffer, which follows the header
+    uint64_t image_checksum;
+    uint64_t reserved; // 0, which keeps the header LSML_SNAPSHOT_HEADER_SIZE bytes, so the buffer after it stays aligned
+    uint64_t header_checksum; // of every field before this one
+} lsml_snapshot_header_t;
+
+static uint64_t lsml_snapshot_checksum(const void *bytes, size_t len) {
+    lsml_string_t string = lsml_string_init((const char *) bytes, len);
+    return lsml_hash_string(&string, lsml_wyp[1]);
+}
+
+// Fills in everything but the checksums.
+static void lsml_snapshot_header_init(lsml_snapshot_header_t *header, size_t image_size) {
+    memset(header, 0, sizeof *header);
+    memcpy(header->magic, "LSMLSNAP", 8);
+    header->version = LSML_SNAPSHOT_VERSION;
+    header->byte_order = LSML_SNAPSHOT_BYTE_ORDER;
+    header->type_sizes = (uint32_t) sizeof(void *) | (uint32_t) sizeof(size_t) << 8 | (uint32_t) LSML_ALIGNOF(lsml_max_align_t) << 16;
+    header->data_size = (uint32_t) sizeof(lsml_data_t);
+    header->section_size = (uint32_t) sizeof(lsml_frozen_section_t);
+    header->entry_size = (uint32_t) sizeof(lsml_frozen_entry_t);
+    header->image_size = (uint64_t) image_size;
+}
+
+lsml_err_t lsml_data_snapshot_header(const lsml_data_t *data, unsigned char *header_buf) {
+    if (data == NULL || !data->frozen) return LSML_ERR_INVALID_DATA;
+    if (header_buf == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_snapshot_header_t header;
+    lsml_snapshot_header_init(&header, data->alloc.size);
+    header.image_checksum = lsml_snapshot_checksum(data, data->alloc.size);
+    header.header_checksum = lsml_snapshot_checksum(&header, offsetof(lsml_snapshot_header_t, header_checksum));
+    memcpy(header_buf, &header, LSML_SNAPSHOT_HEADER_SIZE);
+    return LSML_OK;
+}
+
+// Checks a snapshot's header against this build, setting *header to it.
+static int lsml_snapshot_header_check(const void *header_buf, lsml_snapshot_header_t *header) {
+    lsml_snapshot_header_t expected;
+    if (header_buf == NULL) return 0;
+    memcpy(header, header_buf, LSML_SNAPSHOT_HEADER_SIZE);
+    lsml_snapshot_header_init(&expected, (size_t) header->image_size);
+    if ((uint64_t) expected.image_size != header->image_size) return 0; // doesn't fit in a size_t
+    expected.image_checksum = header->image_checksum;
+    if (memcmp(header, &expected, offsetof(lsml_snapshot_header_t, header_checksum)) != 0) return 0;
+    return header->header_checksum == lsml_snapshot_checksum(header, offsetof(lsml_snapshot_header_t, header_checksum));
+}
+
+// Checks a snapshot's header against this build and the snapshot's length, setting *header to it.
+static int lsml_snapshot_header_ok(const void *snapshot, size_t snapshot_len, lsml_snapshot_header_t *header) {
+    if (snapshot_len < LSML_SNAPSHOT_HEADER_SIZE || !lsml_snapshot_header_check(snapshot, header)) return 0;
+    return header->image_size == (uint64_t) (snapshot_len - LSML_SNAPSHOT_HEADER_SIZE);
+}
+
+lsml_err_t lsml_snapshot_info(const unsigned char *header_buf, size_t *snapshot_len) {
+    lsml_snapshot_header_t header;
+    if (!lsml_snapshot_header_check(header_buf, &header)) return LSML_ERR_INVALID_DATA;
+    if (snapshot_len) *snapshot_len = LSML_SNAPSHOT_HEADER_SIZE + (size_t) header.image_size;
+    return LSML_OK;
+}
+
+lsml_data_t *lsml_data_open_snapshot(void *snapshot, size_t snapshot_len) {
+    lsml_snapshot_header_t header;
+    if (!lsml_snapshot_header_ok(snapshot, snapshot_len, &header)) return NULL;
+    return lsml_data_relocate((char *) snapshot + LSML_SNAPSHOT_HEADER_SIZE, (size_t) header.image_size);
+}
+
+const lsml_data_t *lsml_data_open_snapshot_readonly(const void *snapshot, size_t snapshot_len) {
+    lsml_snapshot_header_t header;
+    if (!lsml_snapshot_header_ok(snapshot, snapshot_len, &header)) return NULL;
+    // opening only checks the data, without writing to it
+    return lsml_data_relocate((char *) snapshot + LSML_SNAPSHOT_HEADER_SIZE, (size_t) header.image_size);
+}
+
+lsml_err_t lsml_snapshot_verify(const void *snapshot, size_t snapshot_len) {
+    lsml_snapshot_header_t header;
+    if (!lsml_snapshot_header_ok(snapshot, snapshot_len, &header)) return LSML_ERR_INVALID_DATA;
+    const char *image = (const char *) snapshot + LSML_SNAPSHOT_HEADER_SIZE;
+    if (header.image_checksum != lsml_snapshot_checksum(image, (size_t) header.image_size)) return LSML_ERR_INVALID_DATA;
+    return LSML_OK;
+}
+
+
+// --- Compacting
+//
+// Nothing a data abandons is given back to its memory: strings of values which were replaced,
+// slots of tables and row starts of arrays which grew, and temporary strings which were discarded.
+// Compacting copies what the data still uses into fresh memory, which leaves the rest behind,
+// since a copy only registers the strings which its sections use (see lsml_data_copy).
+// Tables of the copy already make room for their entries up front, and so does its strings hashmap,
+// once a walk over the sections has counted how many strings they still use.
+
+// Starts an empty data which hashes and logs errors like another, for copying that data into.
+static void lsml_compact_init(lsml_data_t *data, const lsml_data_t *src) {
+    lsml_data_set_seed(data, src->hash_seed);
+    data->err_log = src->err_log;
+    data->err_log_userdata = src->err_log_userdata;
+}
+
+// Marks the slot of one of a data's registered strings, counting it the first time.
+static void lsml_compact_mark(const lsml_data_t *src, unsigned char *marks, lsml_hash_t hash, const lsml_string_t *string, const lsml_reg_str_t *reg_str, size_t *n_marked) {
+    lsml_oa_entry_t *entry = lsml_oa_find(&src->strings, sizeof(lsml_oa_entry_t), hash, string, reg_str);
+    if (entry == NULL) return;
+    size_t slot = (size_t) (entry - (lsml_oa_entry_t *) src->strings.slots);
+    if (marks[slot/8] & (1u << slot%8)) return;
+    marks[slot/8] |= (unsigned char) (1u << slot%8);
+    *n_marked += 1;
+}
+
+// Counts the registered strings which the sections of src still use, which a copy of it registers,
+// marking the slots of src's strings hashmap in temporary memory of data. Without room for the marks, every string is counted.
+static size_t lsml_compact_count_strings(lsml_data_t *data, const lsml_data_t *src) {
+    if (src->frozen) return src->n_strings;
+    size_t size = (src->strings.cap + 7)/8, og_size = 0, n_marked = 0;
+    unsigned char *marks = (unsigned char *) lsml_bump_take_scratch(&data->alloc, size, 1, &og_size);
+    if (marks == NULL) return src->n_strings;
+    memset(marks, 0, size);
+    lsml_iter_t section_iter = {0};
+    lsml_section_t *section;
+    lsml_section_type_t section_type;
+    while (lsml_data_next_section(src, &section_iter, &section, &section_type)) {
+        lsml_compact_mark(src, marks, section->node.str->hash, NULL, section->node.str, &n_marked);
+        lsml_string_t value;
+        if (section_type == LSML_TABLE) {
+            // keys are registered strings, which know their hashes
+            size_t position = 0;
+            for (size_t i = 0; i < section->n_elems; i++) {
+                const lsml_table_entry_t *entry = (const lsml_table_entry_t *) lsml_oa_next(&section->section.table, section->n_elems, sizeof(lsml_table_entry_t), &position);
+                lsml_compact_mark(src, marks, entry->entry.str->hash, NULL, entry->entry.str, &n_marked);
+                lsml_compact_mark(src, marks, lsml_hash_string(&entry->value, src->hash_seed), &entry->value, NULL, &n_marked);
+            }
+        } else if (!section->uninterned) {
+            lsml_iter_t values_iter = {0};
+            while (lsml_array_next(section, &values_iter, &value)) {
+                lsml_compact_mark(src, marks, lsml_hash_string(&value, src->hash_seed), &value, NULL, &n_marked);
+            }
+        }
+    }
+    lsml_bump_give_back_scratch(&data->alloc, marks, size, og_size);
+    return n_marked;
+}
+
+// Copies src into an empty data, making room for n_strings strings first, and mapping that many of src's strings.
+// If making room fails, the strings hashmap grows as strings are added instead.
+// Copying the same src into the same room with the same n_strings always allocates the same way.
+static lsml_err_t lsml_compact_copy(lsml_data_t *data, const lsml_data_t *src, size_t n_strings) {
+    lsml_oa_grow_if_needed(&data->alloc, &data->strings, data->n_strings, n_strings, sizeof(lsml_oa_entry_t));
+    return lsml_copy_data(data, src, 0, n_strings);
+}
+
+// Makes a growable data take over the blocks of a temporary data compacted from it, giving back its own blocks
+// except the one holding it, which ends `data_end` bytes in. Of that block and the temporary data's current block,
+// the one with more room left is allocated from next, and the other is chained below it.
+static void lsml_compact_adopt(lsml_data_t *data, lsml_data_t *temp, size_t data_end) {
+    lsml_block_t *home = lsml_data_free_other_blocks(data);
+    lsml_bump_alloc_t alloc = temp->alloc;
+    *data = *temp;
+    data->alloc.used = alloc.used + alloc.offset + data_end;
+    if (home->size - data_end > alloc.size - alloc.offset) {
+        home->prev = alloc.block;
+        data->alloc.block = home;
+        data->alloc.mem = (char *) home;
+        data->alloc.offset = data_end;
+        data->alloc.size = home->size;
+        data->alloc.used -= data_end;
+    } else {
+        lsml_block_t *first = alloc.block;
+        while (first->prev) first = first->prev;
+        first->prev = home;
+        data->alloc.used -= alloc.offset;
+    }
+}
+
+lsml_data_t *lsml_data_compact(const lsml_data_t *src, void *dst_buf, size_t dst_size, size_t *n_reclaimed) {
+    if (src == NULL) return NULL;
+    lsml_data_t *data = lsml_data_new(dst_buf, dst_size);
+    if (data == NULL) return NULL;
+    lsml_compact_init(data, src);
+    if (lsml_compact_copy(data, src, lsml_compact_count_strings(data, src))) return NULL;
+    size_t og_usage = lsml_data_mem_usage(src), usage = lsml_data_mem_usage(data);
+    if (n_reclaimed) *n_reclaimed = og_usage > usage ? og_usage - usage : 0;
+    return data;
+}
+
+lsml_err_t lsml_data_compact_in_place(lsml_data_t *data, size_t *n_reclaimed) {
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    // sections which were not parsed yet are parsed now, since they would allocate over the compacted copy
+    lsml_freeze_load_all(data);
+    size_t og_usage = lsml_data_mem_usage(data);
+    lsml_data_t *temp;
+    lsml_err_t err;
+    if (n_reclaimed) *n_reclaimed = 0;
+    if (data->alloc.block) {
+        // a growable data is compacted into a temporary one from the same allocator, whose blocks it then takes over,
+        // so it is copied once and is either compacted or left as it was
+        size_t n_strings = lsml_compact_count_strings(data, data);
+        temp = lsml_data_new_growable(data->alloc.allocator, og_usage);
+        if (temp == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        lsml_compact_init(temp, data);
+        err = lsml_compact_copy(temp, data, n_strings);
+        // the data keeps the block it is in, up to its end
+        lsml_block_t *home = data->alloc.block;
+        while ((char *) data < (char *) home || (char *) data >= (char *) home + home->size) home = home->prev;
+        size_t data_end = (size_t) ((char *) data - (char *) home) + sizeof(lsml_data_t);
+        if (err || lsml_data_mem_usage(temp) + data_end >= og_usage) {
+            lsml_data_free(temp);
+            return err;
+        }
+        lsml_compact_adopt(data, temp, data_end);
+    } else {
+        // a fixed data is compacted into its own free memory, and then copied back to the start.
+        // Both copies are made alike, into the same room, so the copy back allocates exactly what the temporary copy did,
+        // which is known to fit before the data is cleared.
+        size_t n_strings = lsml_compact_count_strings(data, data);
+        char *temp_buf = data->alloc.mem + data->alloc.offset;
+        size_t align = LSML_ALIGNOF(lsml_max_align_t);
+        temp_buf += (align - (uintptr_t) temp_buf % align) % align;
+        size_t temp_start = (size_t) (temp_buf - data->alloc.mem);
+        if (temp_start >= data->alloc.size) return LSML_ERR_OUT_OF_MEMORY;
+        // the copy back must end where the temporary copy starts, so it never overwrites it
+        size_t room = data->alloc.size - temp_start;
+        if (room > temp_start) room = temp_start;
+        temp = lsml_data_new(temp_buf, room);
+        if (temp == NULL) return LSML_ERR_OUT_OF_MEMORY;
+        lsml_compact_init(temp, data);
+        err = lsml_compact_copy(temp, data, n_strings);
+        // running out of as much room as the data had means the compacted copy is no smaller
+        if (err == LSML_ERR_OUT_OF_MEMORY && room == temp_start) return LSML_OK;
+        if (err) return err;
+        if (lsml_data_mem_usage(temp) >= og_usage) return LSML_OK;
+        lsml_data_clear(data);
+        size_t og_size = data->alloc.size;
+        data->alloc.size = room;
+        err = lsml_compact_copy(data, temp, n_strings);
+        data->alloc.size = og_size;
+    }
+    if (err) return err;
+    size_t usage = lsml_data_mem_usage(data);
+    if (n_reclaimed) *n_reclaimed = og_usage > usage ? og_usage - usage : 0;
+    return LSML_OK;
+}
+
+// --- IO
+
+
 static int lsml_reader_from_string_getc(void *userdata) {
     if (userdata == NULL) return -1;
     lsml_string_t *src = (lsml_string_t *) userdata;
@@ -992,8 +2900,22 @@ static int lsml_reader_from_string_getc(void *userdata) {
     return c;
 }
 
+// Lends the rest of the string as one block.
+static size_t lsml_reader_from_string_read(void *userdata, char *buf, size_t buf_size, const char **block) {
+    (void) buf;
+    (void) buf_size;
+    if (userdata == NULL) return 0;
+    lsml_string_t *src = (lsml_string_t *) userdata;
+    if (src->str == NULL || src->len == 0) return 0;
+    size_t len = src->len;
+    *block = src->str;
+    src->str += len;
+    src->len = 0;
+    return len;
+}
+
 lsml_reader_t lsml_reader_from_string(lsml_string_t *string) {
-    lsml_reader_t reader = {lsml_reader_from_string_getc, string};
+    lsml_reader_t reader = {lsml_reader_from_string_getc, string, lsml_reader_from_string_read};
     return reader;
 }
 
@@ -1014,36 +2936,242 @@ lsml_err_t lsml_parse_condition_sections_match(lsml_parse_options_t *options, ls
     return LSML_OK;
 }
 
+int lsml_parse_intern_none(void *userdata, lsml_string_t section_name, lsml_section_type_t section_type) {
+    (void) userdata;
+    (void) section_name;
+    (void) section_type;
+    return 0;
+}
+
+
+
+// --- Scanning
+
+// Finds the first byte in [p, end) equal to a, b, or c, returning end if there is none.
+typedef const char *(*lsml_scan_fn)(const char *p, const char *end, unsigned char a, unsigned char b, unsigned char c);
+
+// Portable scanner, checks a word at a time for any matching bytes.
+static const char *lsml_scan_swar(const char *p, const char *end, unsigned char a, unsigned char b, unsigned char c) {
+    const uint64_t ones = 0x0101010101010101u;
+    const uint64_t highs = 0x8080808080808080u;
+    const uint64_t wa = ones*a, wb = ones*b, wc = ones*c;
+    while ((size_t)(end - p) >= sizeof(uint64_t)) {
+        uint64_t w, xa, xb, xc;
+        memcpy(&w, p, sizeof w);
+        xa = w ^ wa;
+        xb = w ^ wb;
+        xc = w ^ wc;
+        // a byte of x is zero if the word matched there
+        if (((xa - ones) & ~xa & highs) | ((xb - ones) & ~xb & highs) | ((xc - ones) & ~xc & highs)) break;
+        p += sizeof(uint64_t);
+    }
+    for (; p < end; p++) {
+        unsigned char ch = (unsigned char) *p;
+        if (ch == a || ch == b || ch == c) return p;
+    }
+    return end;
+}
+
+#ifdef LSML_SSE2
+static const char *lsml_scan_sse2(const char *p, const char *end, unsigned char a, unsigned char b, unsigned char c) {
+    const __m128i va = _mm_set1_epi8((char) a), vb = _mm_set1_epi8((char) b), vc = _mm_set1_epi8((char) c);
+    while ((size_t)(end - p) >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) p);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)), _mm_cmpeq_epi8(v, vc));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(m);
+        if (mask) return p + lsml_ctz(mask);
+        p += 16;
+    }
+    return lsml_scan_swar(p, end, a, b, c);
+}
+#endif
 
+#ifdef LSML_AVX2
+__attribute__((target("avx2")))
+static const char *lsml_scan_avx2(const char *p, const char *end, unsigned char a, unsigned char b, unsigned char c) {
+    const __m256i va = _mm256_set1_epi8((char) a), vb = _mm256_set1_epi8((char) b), vc = _mm256_set1_epi8((char) c);
+    while ((size_t)(end - p) >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) p);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)), _mm256_cmpeq_epi8(v, vc));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(m);
+        if (mask) return p + lsml_ctz(mask);
+        p += 32;
+    }
+    return lsml_scan_sse2(p, end, a, b, c);
+}
+#endif
 
-typedef struct lsml_parser_t {
+// Chooses the scanner for this CPU.
+// Each parser keeps the one it chose, since parsers run on several threads at once (see lsml_parse_parallel),
+// and this only reads the CPU's features, which the compiler's runtime detects before main.
+static lsml_scan_fn lsml_scan_resolve(void) {
+#if defined(LSML_AVX2)
+    return __builtin_cpu_supports("avx2") ? lsml_scan_avx2 : lsml_scan_sse2;
+#elif defined(LSML_SSE2)
+    return lsml_scan_sse2;
+#else
+    return lsml_scan_swar;
+#endif
+}
+
+
+struct lsml_parser_t {
     lsml_reader_t reader;
+    // Window into the current block of input.
+    // `pos` points one past the `next` character, `end` points one past the last byte of the block.
+    const char *pos;
+    const char *end;
+    int eof;
+    // In-place source buffer, only set by lsml_parse_in_place
+    char *src;
+    char *src_end;
+    // If set, in-place strings are not null-terminated yet (see lsml_parse_parallel)
+    int defer_terminators;
     lsml_index_t line;
     int cur;
     int next;
     lsml_parse_err_log_fn log_err;
     void *log_err_userdata;
-} lsml_parser_t;
+    lsml_scan_fn scan; // scanner for this CPU, NULL until first used (see lsml_scan_resolve)
+    // If set, errors and section headers are recorded here instead of logged (see lsml_parse_parallel)
+    struct lsml_parse_events_t *events;
+    // Parse state kept between lines
+    lsml_section_t *section; // the current section, or NULL if skipped
+    size_t n_sections_parsed;
+    int done; // set once enough sections have been parsed
+    // Push parsing state (see lsml_parser_new)
+    lsml_data_t *data;
+    lsml_parse_options_t options;
+    lsml_err_t err; // the first error, returned by every following call
+    char *carry; // holds the start of a line which was not completely fed yet
+    size_t carry_len;
+    size_t carry_cap;
+    char buf[LSML_READ_BLOCK_LEN]; // storage for readers which fill blocks
+};
+
+// Kinds of events recorded by parallel parse workers
+#define LSML_EVENT_ERR 0 // an error was logged
+#define LSML_EVENT_HEADER 1 // a section header starts
+#define LSML_EVENT_SECTION 2 // a section header ends, with the created section (or NULL if skipped)
+
+typedef struct lsml_parse_event_t {
+    lsml_section_t *section;
+    lsml_index_t line;
+    lsml_err_t err;
+    int8_t type;
+} lsml_parse_event_t;
+
+// Fixed-size list of events recorded by a parallel parse worker
+typedef struct lsml_parse_events_t {
+    lsml_parse_event_t *events;
+    size_t n_events;
+    size_t cap;
+} lsml_parse_events_t;
+
+// Records an event if the parser is recording events.
+// Returns nonzero if there is no more space for events, which aborts the parse.
+static int lsml_parser_event(lsml_parser_t *parser, int8_t type, lsml_err_t errcode, lsml_section_t *section) {
+    lsml_parse_events_t *events = parser->events;
+    if (events == NULL) return 0;
+    if (events->n_events >= events->cap) return 1;
+    events->events[events->n_events].section = section;
+    events->events[events->n_events].line = parser->line;
+    events->events[events->n_events].err = errcode;
+    events->events[events->n_events].type = type;
+    events->n_events += 1;
+    return 0;
+}
 
 // Logs an error that occurred during parsing, communicating it to the user.
 // Returns if the user aborts the parsing operation.
 static int lsml_log_err(lsml_parser_t *parser, lsml_err_t errcode) {
+    if (parser && parser->events && errcode) {
+        return lsml_parser_event(parser, LSML_EVENT_ERR, errcode, NULL);
+    }
     if (parser && parser->log_err && errcode) {
         return parser->log_err(parser->log_err_userdata, errcode, parser->line);
     }
     return 0;
 }
 
+// Gets the next block of input from the reader, returning its first character.
+// Leaves parser->pos one past the returned character.
+// Returns a negative number if EOF has been reached or the read failed.
+static int lsml_parser_refill(lsml_parser_t *parser) {
+    const char *block = parser->buf;
+    size_t len = 0;
+    parser->pos = parser->end;
+    if (parser->eof) return -1;
+    if (parser->reader.read_block) {
+        len = parser->reader.read_block(parser->reader.userdata, parser->buf, sizeof parser->buf, &block);
+    } else if (parser->reader.read) {
+        // adapter for single-byte readers: a byte at a time, so input from a pipe or terminal
+        // is parsed as it arrives instead of waiting for a whole block
+        int c = parser->reader.read(parser->reader.userdata);
+        if (c >= 0) {
+            parser->buf[0] = (char) c;
+            len = 1;
+        }
+    }
+    if (len == 0 || block == NULL) {
+        parser->eof = 1;
+        return -1;
+    }
+    parser->pos = block + 1;
+    parser->end = block + len;
+    // must be unsigned char to force value between 0-255
+    return (unsigned char) block[0];
+}
+
 // Advance a parser to the next character.
 // Returns the *current character* of the parser after advancing.
 static inline int lsml_nextchar(lsml_parser_t *parser) {
     int c = parser->next;
     if (parser->cur == '\n') parser->line += 1;
     parser->cur = c;
-    parser->next = lsml_getc(parser->reader);
+    if (parser->pos < parser->end) {
+        parser->next = (unsigned char) *parser->pos;
+        parser->pos++;
+    } else {
+        parser->next = lsml_parser_refill(parser);
+    }
     return c;
 }
 
+// Gets how many characters, starting with parser->next, are within the current window
+// and are none of a, b, or c. These characters start at `parser->pos - 1`.
+static inline size_t lsml_parser_span(lsml_parser_t *parser, int a, int b, int c) {
+    if (parser->next < 0) return 0;
+    if (parser->scan == NULL) parser->scan = lsml_scan_resolve();
+    const char *start = parser->pos - 1;
+    return (size_t)(parser->scan(start, parser->end, (unsigned char) a, (unsigned char) b, (unsigned char) c) - start);
+}
+
+// Advances the parser by n characters at once, as if calling nextchar n times.
+// The characters must be within the current window (see lsml_parser_span) and must not contain a newline.
+// Leaves parser->cur at the last of the n characters.
+static inline void lsml_parser_advance(lsml_parser_t *parser, size_t n) {
+    const char *last = parser->pos - 1 + (n - 1);
+    if (parser->cur == '\n') parser->line += 1;
+    parser->cur = (unsigned char) *last;
+    if (last + 1 < parser->end) {
+        parser->next = (unsigned char) last[1];
+        parser->pos = last + 2;
+    } else {
+        parser->pos = parser->end;
+        parser->next = lsml_parser_refill(parser);
+    }
+}
+
+// Gets the address of parser->cur within the in-place source buffer.
+// Returns the end of the source buffer if parser->cur is EOF.
+// Only valid when parsing in place, since the whole source is a single window.
+static inline char *lsml_parser_src_cur(const lsml_parser_t *parser) {
+    if (parser->cur < 0) return parser->src_end;
+    if (parser->next < 0) return parser->src_end - 1;
+    return parser->src + ((parser->pos - 2) - parser->src);
+}
+
 static int lsml_isspace(int c) {
     switch (c) {
         case ' ':
@@ -1068,20 +3196,39 @@ static void lsml_skip_whitespace(lsml_parser_t *parser) {
 // Skips the rest of the characters in a line,
 // leaving parser->cur at the newline.
 static void lsml_skip_comment(lsml_parser_t *parser) {
-    int c = parser->cur;
-    while(c >= 0 && c != '\n') {
-        c = lsml_nextchar(parser);
+    while (parser->cur >= 0 && parser->cur != '\n') {
+        const char *start, *newline;
+        if (parser->next < 0 || parser->next == '\n') {
+            lsml_nextchar(parser);
+            continue;
+        }
+        // jump to the character before the newline, or to the end of the window
+        start = parser->pos - 1;
+        newline = (const char *) memchr(start, '\n', (size_t)(parser->end - start));
+        lsml_parser_advance(parser, newline ? (size_t)(newline - start) : (size_t)(parser->end - start));
     }
 }
 
 // Skips the rest of the characters in a line,
 // leaving parser->cur at the start of the next line.
 static void lsml_skip_line(lsml_parser_t *parser) {
-    int c = parser->cur;
-    while(c >= 0 && c != '\n') {
-        c = lsml_nextchar(parser);
+    lsml_skip_comment(parser);
+    if (parser->cur == '\n') lsml_nextchar(parser);
+}
+
+// Skips the lines of a skipped section up to the next section header,
+// leaving parser->cur at the start of the section header (or EOF).
+// Only the first non-blank character of each line is looked at, so nothing is parsed or logged.
+static void lsml_skip_section(lsml_parser_t *parser) {
+    for (;;) {
+        lsml_skip_line(parser);
+        while (parser->cur == ' ' || parser->cur == '\t' || parser->cur == '\r') {
+            lsml_nextchar(parser);
+        }
+        if (parser->cur < 0) return;
+        if (parser->cur == '{' && parser->next != '}') return;
+        if (parser->cur == '[' && parser->next != ']') return;
     }
-    if (c == '\n') lsml_nextchar(parser);
 }
 
 // Helper function for parsing octal numbers.
@@ -1171,6 +3318,22 @@ static lsml_err_t lsml_helper_unicode_parse(lsml_parser_t *parser, char **cursor
     return LSML_OK;
 }
 
+// Makes room for n more bytes in the temporary string from start to cursor, which must stay before end.
+// If the current block of a growable data is full, the string is moved to a new block.
+// Returns nonzero if there is no room.
+static int lsml_temp_string_reserve(lsml_data_t *data, char **start, char **cursor, char **end, size_t n) {
+    if ((size_t)(*end - *cursor) >= n) return 0;
+    size_t len = (size_t)(*cursor - *start);
+    // the old copy is left behind, since it was never locked in
+    if (lsml_bump_grow(&data->alloc, 2*(len + n))) return 1;
+    char *new_start = data->alloc.mem + data->alloc.offset;
+    memcpy(new_start, *start, len);
+    *start = new_start;
+    *cursor = new_start + len;
+    *end = data->alloc.mem + data->alloc.size - 1;
+    return 0;
+}
+
 // Parses a single-line string into a buffer at the end of the bump allocator.
 // The string can be unquoted or quoted. Quoted strings handle escape characters.
 // If the function succeeds in creating a string, it leaves the parser->cur character at the ending delimiter of the string:
@@ -1189,19 +3352,27 @@ static lsml_err_t lsml_helper_unicode_parse(lsml_parser_t *parser, char **cursor
 //   - The prefix does not determine whether the string is parsed as quoted or unquoted.
 // - Example: {}hello world -> "{}hello world", {}"\x57" -> "{}W"
 //
+// When parsing in place, strings which are stored verbatim in the source
+// (unquoted strings and quoted strings without escapes) are not copied.
+// Instead, the string points into the source, and a null terminator is written just after it.
+// The overwritten byte is always a delimiter or whitespace which the parser has already passed.
+//
 // USAGE OF TEMPORARY STRINGS
 // - NEVER call `discard_temp_string` after a function which may bump-allocate, double check if data argument is const!
 // - Call `register_temp_string` to fully move ownership of the string into the data, allowing its use in the rest of the parser.
 // - It is unecessary to call `discard_temp_string` if this function fails, since the temporary allocation didn't occur.
 static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parser, lsml_string_t *string, int end_delim, int is_name) {
-    size_t og_offset = data->alloc.offset;
     char *start = data->alloc.mem + data->alloc.offset;
     // cursor points one-past last char in new string
     char *cursor = start;
     char *end = data->alloc.mem + data->alloc.size - 1; // 1 before end for null terminator
+    // if src_start is set, the string is verbatim in the in-place source, from src_start to src_stop
+    char *src_start = NULL;
+    char *src_stop = NULL;
+    char *src_prefix = NULL; // location of the section reference prefix in the in-place source
     string->str = NULL;
     string->len = 0;
-    if (cursor >= end) return LSML_ERR_OUT_OF_MEMORY;
+    if (lsml_temp_string_reserve(data, &start, &cursor, &end, 1)) return LSML_ERR_OUT_OF_MEMORY;
     int c = parser->cur;
     int delim = 0;
     for (;;) {
@@ -1212,7 +3383,8 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
         // Check for section reference prefix if it is the very first thing in the string
         else if (cursor == start && ((c == '{' && parser->next == '}') || (c == '[' && parser->next == ']'))) {
             // save prefix
-            if (cursor+2 > end) return LSML_ERR_OUT_OF_MEMORY;
+            if (lsml_temp_string_reserve(data, &start, &cursor, &end, 2)) return LSML_ERR_OUT_OF_MEMORY;
+            if (parser->src) src_prefix = lsml_parser_src_cur(parser);
             *cursor = (unsigned char) c;
             cursor++;
             *cursor = (unsigned char) parser->next;
@@ -1224,14 +3396,37 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
         // Start of a escapable string
         else if (c == '`') { delim = '`'; c = lsml_nextchar(parser); break; }
         // Start of a quoted string
-        else if (c == '"' || c == '\'') { delim = c; c = lsml_nextchar(parser); break; }
+        else if (c == '"' || c == '\'') {
+            // the string can be used in place if there is no reference prefix between the contents
+            if (parser->src && cursor == start) src_start = lsml_parser_src_cur(parser) + 1;
+            delim = c;
+            c = lsml_nextchar(parser);
+            break;
+        }
         // Start of an unquoted string
-        else if (!lsml_isspace(c)) { delim = '\n'; break; }
+        else if (!lsml_isspace(c)) {
+            if (parser->src) {
+                // the string can be used in place if its reference prefix is right before it
+                char *src = lsml_parser_src_cur(parser);
+                if (cursor == start) src_start = src;
+                else if (src_prefix && src_prefix + 2 == src) src_start = src_prefix;
+                if (src_start) cursor = start; // discard the copied prefix
+            }
+            delim = '\n';
+            break;
+        }
         c = lsml_nextchar(parser);
     }
     if (delim == '\n') { // unquoted string
         for (;;) {
             if (c < 0 || c == '\n' || c == '#' || (end_delim && c == end_delim)) {
+                if (src_start) {
+                    src_stop = lsml_parser_src_cur(parser);
+                    // trim ending whitespace
+                    while (src_stop > src_start && lsml_isspace(*(src_stop-1))) {
+                        src_stop -= 1;
+                    }
+                }
                 if (c == '#') {
                     lsml_skip_comment(parser);
                 }
@@ -1241,10 +3436,22 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
                 }
                 break;
             }
-            // check mem after checking if string is over, maximizing length
-            if (cursor >= end) return LSML_ERR_OUT_OF_MEMORY;
-            *cursor = (unsigned char) c;
-            cursor++;
+            if (!src_start) {
+                // check mem after checking if string is over, maximizing length
+                if (lsml_temp_string_reserve(data, &start, &cursor, &end, 1)) return LSML_ERR_OUT_OF_MEMORY;
+                *cursor = (unsigned char) c;
+                cursor++;
+            }
+            // copy the run of plain characters after c all at once
+            size_t n = lsml_parser_span(parser, '\n', '#', end_delim ? end_delim : '\n');
+            if (!src_start && lsml_temp_string_reserve(data, &start, &cursor, &end, n)) n = (size_t)(end - cursor);
+            if (n > 0) {
+                if (!src_start) {
+                    memcpy(cursor, parser->pos - 1, n);
+                    cursor += n;
+                }
+                lsml_parser_advance(parser, n);
+            }
             c = lsml_nextchar(parser);
         }
     } else if (delim == '"' || delim == '\'') {
@@ -1254,12 +3461,25 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
                 break;
             }
             if (c == delim) break;
-            // check mem after checking if string is over, maximizing length
-            if (cursor >= end) return LSML_ERR_OUT_OF_MEMORY;
-            *cursor = (unsigned char) c;
-            cursor++;
+            if (!src_start) {
+                // check mem after checking if string is over, maximizing length
+                if (lsml_temp_string_reserve(data, &start, &cursor, &end, 1)) return LSML_ERR_OUT_OF_MEMORY;
+                *cursor = (unsigned char) c;
+                cursor++;
+            }
+            // copy the run of plain characters after c all at once
+            size_t n = lsml_parser_span(parser, '\n', delim, delim);
+            if (!src_start && lsml_temp_string_reserve(data, &start, &cursor, &end, n)) n = (size_t)(end - cursor);
+            if (n > 0) {
+                if (!src_start) {
+                    memcpy(cursor, parser->pos - 1, n);
+                    cursor += n;
+                }
+                lsml_parser_advance(parser, n);
+            }
             c = lsml_nextchar(parser);
         }
+        if (src_start) src_stop = lsml_parser_src_cur(parser);
         // pass end quote
         if (c == delim) {
             c = lsml_nextchar(parser);
@@ -1288,7 +3508,7 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
             }
             if (c == '`') break;
             // check mem after checking if string is over, maximizing length
-            if (cursor >= end) return LSML_ERR_OUT_OF_MEMORY;
+            if (lsml_temp_string_reserve(data, &start, &cursor, &end, 1)) return LSML_ERR_OUT_OF_MEMORY;
 
             if (c == '\\') {
                 c = parser->next; // peek next character
@@ -1351,6 +3571,8 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
                     // unicode characters are potentially multi-byte, so use separate function to encode the character
                     case 'u': // \uhhhh (unicode 2-byte codepoint)
                     case 'U': { // \Uhhhhhhhh (unicode 4-byte codepoint)
+                        // the helper writes at most 10 bytes, and checks for room itself if the data can't grow
+                        lsml_temp_string_reserve(data, &start, &cursor, &end, 10);
                         if(lsml_helper_unicode_parse(parser, &cursor, end)) return LSML_ERR_OUT_OF_MEMORY;
                         c = parser->cur;
                         continue;
@@ -1364,6 +3586,14 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
             } // if escaped sequence
             *cursor = (unsigned char) c;
             cursor++;
+            // copy the run of plain characters after c all at once
+            size_t n = lsml_parser_span(parser, '\n', '`', '\\');
+            if (lsml_temp_string_reserve(data, &start, &cursor, &end, n)) n = (size_t)(end - cursor);
+            if (n > 0) {
+                memcpy(cursor, parser->pos - 1, n);
+                cursor += n;
+                lsml_parser_advance(parser, n);
+            }
             c = lsml_nextchar(parser);
         }
         // pass end quote
@@ -1388,22 +3618,39 @@ static lsml_err_t lsml_parse_temp_string(lsml_data_t *data, lsml_parser_t *parse
         }
     }
     save_string:
+    if (src_start) {
+        size_t len = (size_t)(src_stop - src_start);
+        if (is_name && len == 0) return LSML_ERR_INVALID_KEY;
+        if (src_stop < parser->src_end && !(parser->defer_terminators && (is_name || len == 0))) {
+            // use the string in place, nothing is allocated
+            if (!parser->defer_terminators) *src_stop = 0;
+            string->str = src_start;
+            string->len = len;
+            return LSML_OK;
+        }
+        // no room for the null terminator at the end of the source, so copy it instead
+        // (names and empty strings are copied when terminators are deferred, since they must be null-terminated)
+        if (lsml_temp_string_reserve(data, &start, &cursor, &end, len)) return LSML_ERR_OUT_OF_MEMORY;
+        memcpy(cursor, src_start, len);
+        cursor += len;
+    }
     // Check zero length
     if (is_name && (cursor == start)) return LSML_ERR_INVALID_KEY;
     *cursor = 0; // null terminator
     string->str = start;
     string->len = (size_t)(cursor - start);
     // the following allocation is already validated by checking that cursor <= end in the loops
-    data->alloc.offset = og_offset + string->len + 1; // lock-in string allocation
+    data->alloc.offset = (size_t)(start - data->alloc.mem) + string->len + 1; // lock-in string allocation
     return LSML_OK;
 }
 
 // Discards memory associated with the temporary string,
 // setting data->alloc.offset to the start of the string.
+// Strings which were parsed in place did not allocate, so they are only cleared.
 // WARNING: DO NOT CALL THIS AFTER OTHER ALLOCATIONS BESIDES `parse_temp_string`.
 static void lsml_discard_temp_string(lsml_data_t *data, lsml_string_t *temp_string) {
     if (temp_string->str == NULL) return;
-    data->alloc.offset = (size_t)(temp_string->str - data->alloc.mem);
+    if (lsml_bump_owns_ptr(&data->alloc, temp_string->str)) data->alloc.offset = (size_t)(temp_string->str - data->alloc.mem);
     temp_string->str = NULL;
     temp_string->len = 0;
 }
@@ -1420,8 +3667,36 @@ static lsml_err_t lsml_register_temp_string(lsml_data_t *data, lsml_string_t *st
     }
     // make temp string the actual one
     *string = (*reg_str)->string;
-    // rehash to keep lookup times good
-    return lsml_hm_rehash_if_needed(&data->alloc, data->strings_head, (void**) &data->strings_tail, data->n_strings, &data->n_strings_chunks);
+    return LSML_OK;
+}
+
+// Stores a value for an array, interned with the data's strings unless the array stores its values on their own.
+// If move_string is nonzero, the string is used where it is, like a temporary string being registered.
+// Otherwise, it is copied.
+static lsml_err_t lsml_array_store_value(lsml_data_t *data, lsml_section_t *array, lsml_string_t *string, int move_string, lsml_string_t *value) {
+    lsml_err_t err;
+    if (!array->uninterned) {
+        size_t n_strings = data->n_strings;
+        lsml_reg_str_t *reg_str;
+        if (move_string) err = lsml_register_temp_string(data, string, &reg_str);
+        else err = lsml_data_register_string(data, string->str, string->len, 0, &reg_str);
+        if (err) return err;
+        array->n_interned += 1;
+        if (data->n_strings == n_strings) array->n_reused += 1;
+        *value = reg_str->string;
+        return LSML_OK;
+    }
+    // the array holds the value's descriptor, so only its bytes are stored
+    if (move_string) {
+        *value = *string;
+        return LSML_OK;
+    }
+    char *buf = lsml_bump_alloc_string(&data->alloc, string->len+1);
+    if (buf == NULL) return LSML_ERR_OUT_OF_MEMORY;
+    memcpy(buf, string->str, string->len);
+    buf[string->len] = 0;
+    *value = lsml_string_init(buf, string->len);
+    return LSML_OK;
 }
 
 static lsml_err_t lsml_parse_section_header(lsml_data_t *data, lsml_parser_t *parser, lsml_section_t **section, lsml_parse_condition_fn cond, void *userdata) {
@@ -1495,8 +3770,7 @@ static lsml_err_t lsml_parse_table_entry(lsml_data_t *data, lsml_parser_t *parse
     err = lsml_register_temp_string(data, &temp_key, &key);
     if (err) return err;
     // Plus, registering the string makes lookup faster.
-    lsml_table_node_t *table_node = (lsml_table_node_t *) lsml_hm_get_node_reg(table->section.table, table->n_chunks, key);
-    if (table_node) {
+    if (lsml_oa_find(&table->section.table, sizeof(lsml_table_entry_t), key->hash, NULL, key)) {
         // it's still valid syntax, the entry is just skipped
         if (lsml_log_err(parser, LSML_ERR_TABLE_KEY_REUSED)) return LSML_ERR_PARSE_ABORTED;
         return LSML_OK;
@@ -1514,41 +3788,35 @@ static lsml_err_t lsml_parse_table_entry(lsml_data_t *data, lsml_parser_t *parse
 
 static lsml_err_t lsml_parse_array_entries(lsml_data_t *data, lsml_parser_t *parser, lsml_section_t *array) {
     lsml_string_t temp_val;
-    lsml_reg_str_t *val;
+    lsml_string_t val;
     lsml_err_t err;
     int newrow = 1;
     // PARSE COMMA-SEPARATED VALUE
     while (parser->cur >= 0 && parser->cur != '\n' && parser->cur != '#') {
         err = lsml_parse_temp_string(data, parser, &temp_val, ',', 0);
         if (err) return err;
-        err = lsml_register_temp_string(data, &temp_val, &val);
+        err = lsml_array_store_value(data, array, &temp_val, 1, &val);
         if (err) return err;
-        err = lsml_array_add_entry_internal(data, array, &val->string, newrow);
+        err = lsml_array_add_entry_internal(data, array, &val, newrow);
         if (err) return err;
         newrow = 0; // set to 0 after first loop so the first element starts the row
         
         // pass delimiter
         if (parser->cur == ',') lsml_nextchar(parser);
-        if (parser->cur == '\n') break;
-        lsml_skip_whitespace(parser);
+        // skip whitespace, but stay on this line
+        while (parser->cur == ' ' || parser->cur == '\t' || parser->cur == '\r') {
+            lsml_nextchar(parser);
+        }
     }
     return LSML_OK;
 }
 
-lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_options_t options) {
-    lsml_parser_t parser_data = {0};
-    lsml_parser_t *parser = &parser_data;
-    lsml_section_t *section = NULL;
-    size_t n_sections_parsed = 0;
+// Parses lines from the parser's input into the data until the input stops,
+// continuing from the parser's current section and line.
+// Also stops once enough sections have been parsed, which sets parser->done.
+static lsml_err_t lsml_parse_lines(lsml_data_t *data, lsml_parser_t *parser, lsml_parse_options_t options) {
     int c;
     lsml_err_t err = LSML_OK;
-    // Initialize parser
-    if (data == NULL) return LSML_ERR_INVALID_DATA;
-    if (reader.read == NULL) return LSML_OK; // nothing to read
-    parser_data.reader = reader,
-    parser_data.line=1,
-    parser_data.log_err = options.err_log,
-    parser_data.log_err_userdata = options.err_log_userdata,
     lsml_nextchar(parser); // cur = 0, next = first
     c = lsml_nextchar(parser); // c = cur = first, next = second
     while(c >= 0) {
@@ -1557,16 +3825,20 @@ lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_option
         c = parser->cur;
         if ((c == '{' && parser->next != '}') || (c == '[' && parser->next != ']')) { // start a section, not a section reference
             // check if enough sections have been parsed
-            if (options.n_sections != 0 && n_sections_parsed >= options.n_sections) return LSML_OK;
-            n_sections_parsed += 1;
-            err = lsml_parse_section_header(data, parser, &section, options.condition, options.condition_userdata);
+            if (options.n_sections != 0 && parser->n_sections_parsed >= options.n_sections) {
+                parser->done = 1;
+                return LSML_OK;
+            }
+            parser->n_sections_parsed += 1;
+            if (lsml_parser_event(parser, LSML_EVENT_HEADER, LSML_OK, NULL)) return LSML_ERR_PARSE_ABORTED;
+            err = lsml_parse_section_header(data, parser, &parser->section, options.condition, options.condition_userdata);
             switch (err) {
                 case LSML_OK:
                     break;
                 case LSML_ERR_SECTION_NAME_REUSED:
                 case LSML_ERR_SECTION_NAME_EMPTY:
                     // skip the section by setting pointer to NULL
-                    section = NULL;
+                    parser->section = NULL;
                     // and log the error
                     if (lsml_log_err(parser, err)) return LSML_ERR_PARSE_ABORTED;
                     break;
@@ -1574,15 +3846,18 @@ lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_option
                 default:
                     return err;
             }
-            // if (section->row_indices) last_row_index = section->row_indices;
+            if (parser->section && parser->section->row_starts && options.intern_arrays) {
+                parser->section->uninterned = !options.intern_arrays(options.intern_arrays_userdata, parser->section->node.str->string, LSML_ARRAY);
+            }
+            if (lsml_parser_event(parser, LSML_EVENT_SECTION, LSML_OK, parser->section)) return LSML_ERR_PARSE_ABORTED;
         } else if (c == '#') {
             lsml_skip_comment(parser);
         } else if (c >= 0) { // parse an entry
-            if (section) { // section started or section isn't skipped
-                if (section->row_indices) {
-                    err = lsml_parse_array_entries(data, parser, section);
+            if (parser->section) { // section started or section isn't skipped
+                if (parser->section->row_starts) {
+                    err = lsml_parse_array_entries(data, parser, parser->section);
                 } else {
-                    err = lsml_parse_table_entry(data, parser, section);
+                    err = lsml_parse_table_entry(data, parser, parser->section);
                 }
                 switch (err) {
                     case LSML_OK: break;
@@ -1596,10 +3871,14 @@ lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_option
                 }
             } else if(data->n_sections == 0) { // this entry occurred before any section, this is an error
                 if (lsml_log_err(parser, LSML_ERR_TEXT_OUTSIDE_SECTION)) return LSML_ERR_PARSE_ABORTED;
+            } else {
+                // if there is no section but there are existing sections,
+                // then the section was skipped by the condition or because of an issue with its name,
+                // in which case the error was already logged, so skip straight to the next section.
+                lsml_skip_section(parser);
+                c = parser->cur;
+                continue;
             }
-            // if there is no section but there are existing sections,
-            // then the section was skipped because of an issue with its name,
-            // in which case the error was already logged.
         }
         // INVARIANT: if the parsed value ended on a newline, parser->cur should be left on the newline
         // This is so skip_line doesn't skip the next valid line
@@ -1609,6 +3888,822 @@ lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_option
     return LSML_OK;
 }
 
+// Parses everything from the parser's reader into the data.
+// The parser's reader, source, and starting line must be set, everything else is initialized here.
+static lsml_err_t lsml_parse_internal(lsml_data_t *data, lsml_parser_t *parser, lsml_parse_options_t options) {
+    parser->log_err = options.err_log;
+    parser->log_err_userdata = options.err_log_userdata;
+    return lsml_parse_lines(data, parser, options);
+}
+
+lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_options_t options) {
+    lsml_parser_t parser = {0};
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (reader.read == NULL && reader.read_block == NULL) return LSML_OK; // nothing to read
+    parser.reader = reader;
+    parser.line = 1;
+    return lsml_parse_internal(data, &parser, options);
+}
+
+lsml_err_t lsml_parse_in_place(lsml_data_t *data, char *buf, size_t len, lsml_parse_options_t options) {
+    lsml_parser_t parser = {0};
+    lsml_string_t src;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (buf == NULL || len == 0) return LSML_OK; // nothing to read
+    src.str = buf;
+    src.len = len;
+    // the string reader lends the whole buffer as one window
+    parser.reader = lsml_reader_from_string(&src);
+    parser.src = buf;
+    parser.src_end = buf + len;
+    parser.line = 1;
+    return lsml_parse_internal(data, &parser, options);
+}
+
+// -- Measuring
+//
+// Measuring follows the same allocations as parsing, without building anything.
+// Each string is parsed into a small scratch data to get its length, and then discarded.
+// Every string is assumed to be new and every entry is assumed to be added, since finding repeats needs the parsed data.
+// Strings too long for the scratch data are measured by the rest of their line, since escape sequences never get longer.
+// Temporary strings need room even if they are discarded, so the most memory used at once is tracked as well.
+// Unquoted strings also need room for the whitespace they trim, so the scratch memory is kept zero past the strings
+// to find how much was written.
+
+typedef struct lsml_measure_t {
+    size_t offset; // offset of the bump allocator
+    size_t peak; // most memory used at once, including temporary strings
+    size_t n_sections;
+    size_t n_section_chunks;
+    size_t n_strings;
+    size_t strings_cap;
+    // current section
+    int in_section;
+    lsml_section_type_t type;
+    int uninterned; // if the current array stores its values on their own
+    size_t n_elems;
+    size_t n_chunks; // chunks of an array, or slots of a table
+    size_t n_rows;
+    // scratch memory for parsing strings
+    lsml_data_t *scratch;
+    size_t scratch_dirty; // bytes of the scratch memory which may not be zero
+    lsml_parse_condition_fn condition;
+    void *condition_userdata;
+    lsml_max_align_t scratch_mem[LSML_MEASURE_SCRATCH_LEN / sizeof(lsml_max_align_t) + 1];
+} lsml_measure_t;
+
+static void lsml_measure_alloc(lsml_measure_t *measure, size_t size, size_t align) {
+    measure->offset = ((measure->offset + (align-1)) & ~(align-1)) + size;
+}
+
+// Measures parsing a temporary string with given length, which needs room for its null terminator and one more byte.
+static void lsml_measure_temp(lsml_measure_t *measure, size_t len) {
+    size_t needed = measure->offset + len + 2;
+    if (needed > measure->peak) measure->peak = needed;
+}
+
+static void lsml_measure_rehash(lsml_measure_t *measure, size_t n_elems, size_t *n_chunks) {
+    if (*n_chunks == 0 || !lsml_hm_over_load(n_elems, *n_chunks)) return;
+    lsml_measure_alloc(measure, 2*(*n_chunks)*sizeof(void *), LSML_ALIGNOF(void *));
+    for (size_t i = 0; i < *n_chunks; i++) {
+        lsml_measure_alloc(measure, sizeof(lsml_cha_chunk_t), LSML_ALIGNOF(lsml_cha_chunk_t));
+    }
+    *n_chunks *= 2;
+}
+
+static void lsml_measure_oa_init(lsml_measure_t *measure, size_t entry_size, size_t cap, int ordered) {
+    lsml_measure_alloc(measure, cap*entry_size, LSML_ALIGNOF(lsml_oa_entry_t));
+    lsml_measure_alloc(measure, cap, 1);
+    if (ordered) lsml_measure_alloc(measure, lsml_oa_max_elems(cap)*sizeof(uint32_t), LSML_ALIGNOF(uint32_t));
+}
+
+static void lsml_measure_oa_grow(lsml_measure_t *measure, size_t n_elems, size_t entry_size, size_t *cap, int ordered) {
+    if (!lsml_oa_over_load(n_elems, *cap)) return;
+    *cap *= 2;
+    lsml_measure_oa_init(measure, entry_size, *cap, ordered);
+}
+
+// Measures registering a string with given length.
+static void lsml_measure_string(lsml_measure_t *measure, size_t len) {
+    lsml_measure_alloc(measure, len + 1, LSML_ALIGNOF(char));
+    lsml_measure_alloc(measure, sizeof(lsml_reg_str_t), LSML_ALIGNOF(lsml_reg_str_t));
+    measure->n_strings += 1;
+    lsml_measure_oa_grow(measure, measure->n_strings, sizeof(lsml_oa_entry_t), &measure->strings_cap, 0);
+}
+
+// Measures n strings which together have up to len bytes, along with the padding they may need.
+static void lsml_measure_strings(lsml_measure_t *measure, size_t len, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        lsml_measure_string(measure, i == 0 ? len + n*sizeof(lsml_max_align_t) : 0);
+    }
+}
+
+// Measures storing an array value, like lsml_array_store_value.
+static void lsml_measure_value(lsml_measure_t *measure, size_t len) {
+    if (!measure->uninterned) {
+        lsml_measure_string(measure, len);
+        return;
+    }
+    lsml_measure_alloc(measure, len + 1, LSML_ALIGNOF(char));
+}
+
+// Skips the rest of the line like lsml_skip_comment, counting its characters and commas.
+static size_t lsml_measure_line(lsml_parser_t *parser, size_t *n_commas) {
+    size_t len = 0;
+    while (parser->cur >= 0 && parser->cur != '\n') {
+        const char *start, *stop;
+        len += 1;
+        if (parser->cur == ',') *n_commas += 1;
+        if (parser->next < 0 || parser->next == '\n') {
+            lsml_nextchar(parser);
+            continue;
+        }
+        // count the characters up to the newline, or to the end of the window
+        start = parser->pos - 1;
+        stop = (const char *) memchr(start, '\n', (size_t)(parser->end - start));
+        if (stop == NULL) stop = parser->end;
+        for (const char *p = start; p < stop; p++) {
+            if (*p == ',') *n_commas += 1;
+        }
+        len += (size_t)(stop - start);
+        lsml_parser_advance(parser, (size_t)(stop - start));
+        lsml_nextchar(parser);
+    }
+    return len;
+}
+
+// Clears the scratch memory from given offset, so strings parsed there can be measured by lsml_measure_written.
+static void lsml_measure_clear_scratch(lsml_measure_t *measure, size_t from) {
+    if (measure->scratch_dirty > from) memset((char *) measure->scratch_mem + from, 0, measure->scratch_dirty - from);
+    measure->scratch_dirty = from;
+}
+
+// Starts over with an empty scratch data.
+static void lsml_measure_new_scratch(lsml_measure_t *measure) {
+    lsml_measure_clear_scratch(measure, 0);
+    measure->scratch = lsml_data_new(measure->scratch_mem, sizeof measure->scratch_mem);
+    measure->scratch_dirty = measure->scratch->alloc.offset;
+}
+
+// Gets how many bytes were written to the scratch memory for a temporary string with given offset and length,
+// not counting its null terminator, which includes any whitespace trimmed off its end.
+static size_t lsml_measure_written(lsml_measure_t *measure, size_t start, size_t len) {
+    const char *mem = (const char *) measure->scratch_mem;
+    size_t stop = start + len;
+    // whitespace trimmed off the end is left past the null terminator, which overwrote the first of it
+    size_t ws = stop + 1;
+    while (ws < sizeof measure->scratch_mem && lsml_isspace(mem[ws])) ws++;
+    if (ws > stop + 1) stop = ws - 1;
+    if (stop + 1 > measure->scratch_dirty) measure->scratch_dirty = stop + 1;
+    return stop - start;
+}
+
+// Parses a string into the scratch data to get its length.
+// If the string doesn't fit, the rest of the line is skipped and its length is used instead,
+// with the number of commas in it, which bounds the number of array values in it.
+static lsml_err_t lsml_measure_temp_string(lsml_measure_t *measure, lsml_parser_t *parser, int end_delim, size_t *len, size_t *n_commas) {
+    lsml_string_t temp;
+    size_t start = measure->scratch->alloc.offset;
+    lsml_err_t err = lsml_parse_temp_string(measure->scratch, parser, &temp, end_delim, 0);
+    *n_commas = 0;
+    if (err == LSML_ERR_OUT_OF_MEMORY) {
+        *len = LSML_MEASURE_SCRATCH_LEN + lsml_measure_line(parser, n_commas);
+        lsml_measure_temp(measure, *len);
+        measure->scratch_dirty = sizeof measure->scratch_mem;
+        lsml_measure_clear_scratch(measure, start);
+        return err;
+    }
+    lsml_measure_temp(measure, lsml_measure_written(measure, start, temp.len));
+    lsml_measure_clear_scratch(measure, start);
+    if (err) return err;
+    *len = temp.len;
+    lsml_discard_temp_string(measure->scratch, &temp);
+    return LSML_OK;
+}
+
+// Measures the temporary name of a section before calling the user's condition, since the name is discarded if it is skipped.
+static int lsml_measure_condition(void *userdata, lsml_string_t section_name, lsml_section_type_t section_type) {
+    lsml_measure_t *measure = (lsml_measure_t *) userdata;
+    lsml_measure_temp(measure, lsml_measure_written(measure, (size_t)(section_name.str - (const char *) measure->scratch_mem), section_name.len));
+    return measure->condition ? measure->condition(measure->condition_userdata, section_name, section_type) : 1;
+}
+
+static void lsml_measure_section(lsml_measure_t *measure, size_t name_len, lsml_section_type_t type) {
+    lsml_measure_string(measure, name_len);
+    lsml_measure_rehash(measure, measure->n_sections, &measure->n_section_chunks);
+    if (type == LSML_ARRAY) lsml_measure_alloc(measure, sizeof(size_t), LSML_ALIGNOF(size_t));
+    lsml_measure_alloc(measure, sizeof(lsml_section_t), LSML_ALIGNOF(lsml_section_t));
+    measure->n_sections += 1;
+    measure->in_section = 1;
+    measure->type = type;
+    measure->uninterned = 0;
+    measure->n_elems = 0;
+    measure->n_chunks = 0;
+    measure->n_rows = 1;
+}
+
+// Measures adding an entry to the current section, like lsml_table_add_entry_internal and lsml_array_add_entry_internal.
+static void lsml_measure_entry(lsml_measure_t *measure, int newrow) {
+    if (measure->type == LSML_TABLE) {
+        if (measure->n_chunks == 0) {
+            measure->n_chunks = LSML_OA_GROUP_LEN;
+            lsml_measure_oa_init(measure, sizeof(lsml_table_entry_t), measure->n_chunks, 1);
+        }
+        lsml_measure_oa_grow(measure, measure->n_elems + 1, sizeof(lsml_table_entry_t), &measure->n_chunks, 1);
+    } else {
+        if (newrow && measure->n_elems > 0) {
+            if ((measure->n_rows & (measure->n_rows - 1)) == 0) lsml_measure_alloc(measure, 2*measure->n_rows*sizeof(size_t), LSML_ALIGNOF(size_t));
+            measure->n_rows += 1;
+        }
+        if (measure->n_chunks == 0) {
+            lsml_measure_alloc(measure, sizeof(lsml_array_chunk_t), LSML_ALIGNOF(lsml_array_chunk_t));
+            measure->n_chunks = 1;
+        }
+        if (measure->n_elems >= measure->n_chunks*LSML_ARRAY_CHUNK_LEN) {
+            if ((measure->n_chunks & (measure->n_chunks - 1)) == 0) lsml_measure_alloc(measure, 2*measure->n_chunks*sizeof(void *), LSML_ALIGNOF(void *));
+            lsml_measure_alloc(measure, sizeof(lsml_array_chunk_t), LSML_ALIGNOF(lsml_array_chunk_t));
+            measure->n_chunks += 1;
+        }
+    }
+    measure->n_elems += 1;
+}
+
+// Measures parsing a table entry, following lsml_parse_table_entry.
+static void lsml_measure_table_entry(lsml_measure_t *measure, lsml_parser_t *parser) {
+    size_t len, n_commas;
+    lsml_err_t err = lsml_measure_temp_string(measure, parser, '=', &len, &n_commas);
+    if (err == LSML_ERR_OUT_OF_MEMORY) {
+        // the whole line is split between the key and value
+        lsml_measure_strings(measure, len, 2);
+        lsml_measure_entry(measure, 0);
+        return;
+    }
+    if (err || parser->cur != '=') return;
+    lsml_nextchar(parser);
+    lsml_measure_string(measure, len); // key
+    err = lsml_measure_temp_string(measure, parser, '\n', &len, &n_commas);
+    if (err && err != LSML_ERR_OUT_OF_MEMORY) return;
+    lsml_measure_strings(measure, len, 1); // value
+    lsml_measure_entry(measure, 0);
+}
+
+// Measures parsing a row of array values, following lsml_parse_array_entries.
+static void lsml_measure_array_entries(lsml_measure_t *measure, lsml_parser_t *parser) {
+    size_t len, n_commas;
+    int newrow = 1;
+    while (parser->cur >= 0 && parser->cur != '\n' && parser->cur != '#') {
+        lsml_err_t err = lsml_measure_temp_string(measure, parser, ',', &len, &n_commas);
+        if (err == LSML_ERR_OUT_OF_MEMORY) {
+            // the rest of the line may have a value after every comma
+            for (size_t i = 0; i < n_commas + 1; i++) {
+                lsml_measure_value(measure, (i == 0 ? len + n_commas*sizeof(lsml_max_align_t) : 0) + sizeof(lsml_max_align_t));
+                lsml_measure_entry(measure, newrow);
+                newrow = 0;
+            }
+            return;
+        }
+        if (err) return;
+        lsml_measure_value(measure, len);
+        lsml_measure_entry(measure, newrow);
+        newrow = 0;
+        if (parser->cur == ',') lsml_nextchar(parser);
+        while (parser->cur == ' ' || parser->cur == '\t' || parser->cur == '\r') {
+            lsml_nextchar(parser);
+        }
+    }
+}
+
+lsml_err_t lsml_parse_measure(lsml_reader_t reader, lsml_parse_options_t options, size_t *bytes_needed) {
+    lsml_parser_t parser = {0};
+    lsml_measure_t measure = {0};
+    size_t n_sections_parsed = 0;
+    int c;
+    if (bytes_needed == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_measure_new_scratch(&measure);
+    // a new data
+    lsml_measure_alloc(&measure, sizeof(lsml_data_t), LSML_ALIGNOF(lsml_data_t));
+    lsml_measure_alloc(&measure, sizeof(lsml_section_chunk_t), LSML_ALIGNOF(lsml_section_chunk_t));
+    measure.strings_cap = LSML_OA_GROUP_LEN;
+    lsml_measure_oa_init(&measure, sizeof(lsml_oa_entry_t), measure.strings_cap, 0);
+    measure.n_section_chunks = 1;
+    measure.condition = options.condition;
+    measure.condition_userdata = options.condition_userdata;
+    parser.reader = reader;
+    parser.line = 1;
+    lsml_nextchar(&parser);
+    c = lsml_nextchar(&parser);
+    // follows lsml_parse_lines
+    while (c >= 0) {
+        lsml_skip_whitespace(&parser);
+        c = parser.cur;
+        if ((c == '{' && parser.next != '}') || (c == '[' && parser.next != ']')) {
+            lsml_section_type_t type = c == '{' ? LSML_TABLE : LSML_ARRAY;
+            lsml_section_t *section = NULL;
+            lsml_err_t err;
+            size_t start = measure.scratch->alloc.offset;
+            if (options.n_sections != 0 && n_sections_parsed >= options.n_sections) break;
+            n_sections_parsed += 1;
+            // parse the header for real, so the condition gets the section's name
+            err = lsml_parse_section_header(measure.scratch, &parser, &section, lsml_measure_condition, &measure);
+            if (err == LSML_OK && section) {
+                lsml_measure_section(&measure, section->node.str->string.len, type);
+                if (type == LSML_ARRAY && options.intern_arrays) {
+                    measure.uninterned = !options.intern_arrays(options.intern_arrays_userdata, section->node.str->string, LSML_ARRAY);
+                }
+            } else if (err == LSML_ERR_OUT_OF_MEMORY) {
+                // the name is too long for the scratch data, so measure it as the rest of the line
+                size_t n_commas = 0;
+                size_t len = LSML_MEASURE_SCRATCH_LEN + lsml_measure_line(&parser, &n_commas) + sizeof(lsml_max_align_t);
+                lsml_measure_temp(&measure, len);
+                lsml_measure_section(&measure, len, type);
+                measure.scratch_dirty = sizeof measure.scratch_mem;
+            } else {
+                // skipped by the condition or because of an issue with its name, which wasn't measured then
+                if (err) lsml_measure_temp(&measure, lsml_measure_written(&measure, start, 0));
+                measure.in_section = 0;
+            }
+            // start over, so the scratch data only holds strings
+            lsml_measure_new_scratch(&measure);
+        } else if (c == '#') {
+            lsml_skip_comment(&parser);
+        } else if (c >= 0 && measure.in_section) {
+            if (measure.type == LSML_ARRAY) lsml_measure_array_entries(&measure, &parser);
+            else lsml_measure_table_entry(&measure, &parser);
+        }
+        lsml_skip_line(&parser);
+        c = parser.cur;
+    }
+    // the bump allocator never fills its last byte
+    *bytes_needed = measure.peak > measure.offset ? measure.peak : measure.offset + 1;
+    return LSML_OK;
+}
+
+// -- Push Parsing
+//
+// Every token ends at a newline, so fed input is parsed one complete line at a time.
+// Complete lines are parsed directly from the fed buffer, and only a partial line at the end is copied,
+// to be completed by the following feeds.
+
+// Points the parser at a buffer of complete lines, keeping the current section and line number.
+static void lsml_parser_set_input(lsml_parser_t *parser, const char *buf, size_t len) {
+    lsml_reader_t no_reader = {0};
+    parser->reader = no_reader;
+    parser->pos = buf;
+    parser->end = buf + len;
+    parser->eof = 1; // nothing to refill from after the buffer
+    parser->cur = 0;
+    parser->next = 0;
+}
+
+static lsml_err_t lsml_parser_push_lines(lsml_parser_t *parser, const char *buf, size_t len) {
+    lsml_parser_set_input(parser, buf, len);
+    parser->err = lsml_parse_lines(parser->data, parser, parser->options);
+    return parser->err;
+}
+
+static lsml_err_t lsml_parser_carry(lsml_parser_t *parser, const char *buf, size_t len) {
+    if (len > parser->carry_cap - parser->carry_len) {
+        // the line is too long for the parser's memory
+        parser->err = LSML_ERR_OUT_OF_MEMORY;
+        return parser->err;
+    }
+    memcpy(parser->carry + parser->carry_len, buf, len);
+    parser->carry_len += len;
+    return LSML_OK;
+}
+
+size_t lsml_parser_mem_size(size_t max_line_len) {
+    return sizeof(lsml_parser_t) + sizeof(lsml_max_align_t) + max_line_len;
+}
+
+lsml_parser_t *lsml_parser_new(void *buf, size_t size, lsml_data_t *data, lsml_parse_options_t options) {
+    lsml_bump_alloc_t alloc = {0};
+    lsml_parser_t *parser;
+    if (buf == NULL || data == NULL) return NULL;
+    alloc.mem = (char *) buf;
+    alloc.size = size;
+    parser = (lsml_parser_t *) lsml_bump_alloc(&alloc, sizeof(lsml_parser_t), LSML_ALIGNOF(lsml_parser_t));
+    if (parser == NULL) return NULL;
+    memset(parser, 0, sizeof(lsml_parser_t));
+    parser->line = 1;
+    parser->log_err = options.err_log;
+    parser->log_err_userdata = options.err_log_userdata;
+    parser->data = data;
+    parser->options = options;
+    // the rest of the memory holds partial lines
+    parser->carry = alloc.mem + alloc.offset;
+    parser->carry_cap = alloc.size - alloc.offset;
+    return parser;
+}
+
+lsml_err_t lsml_parser_feed(lsml_parser_t *parser, const char *buf, size_t len) {
+    const char *end = buf + len;
+    const char *last_line;
+    if (parser == NULL) return LSML_ERR_INVALID_DATA;
+    if (parser->err) return parser->err;
+    if (parser->done || buf == NULL || len == 0) return LSML_OK;
+    if (parser->carry_len) {
+        // complete the carried line first
+        const char *newline = (const char *) memchr(buf, '\n', len);
+        if (newline == NULL) return lsml_parser_carry(parser, buf, len);
+        if (lsml_parser_carry(parser, buf, (size_t)(newline + 1 - buf))) return parser->err;
+        if (lsml_parser_push_lines(parser, parser->carry, parser->carry_len)) return parser->err;
+        parser->carry_len = 0;
+        buf = newline + 1;
+        if (parser->done) return LSML_OK;
+    }
+    // find the end of the last complete line
+    last_line = end;
+    while (last_line > buf && last_line[-1] != '\n') last_line--;
+    if (last_line > buf) {
+        if (lsml_parser_push_lines(parser, buf, (size_t)(last_line - buf))) return parser->err;
+        if (parser->done) return LSML_OK;
+    }
+    return lsml_parser_carry(parser, last_line, (size_t)(end - last_line));
+}
+
+lsml_err_t lsml_parser_finish(lsml_parser_t *parser) {
+    if (parser == NULL) return LSML_ERR_INVALID_DATA;
+    if (parser->err) return parser->err;
+    if (!parser->done && parser->carry_len) {
+        // the last line has no newline at the end
+        if (lsml_parser_push_lines(parser, parser->carry, parser->carry_len)) return parser->err;
+    }
+    parser->carry_len = 0;
+    parser->done = 1;
+    return LSML_OK;
+}
+
+// -- Section Header Lines
+//
+// Lines are parsed independently, so input can be split at section header lines without parsing it.
+
+// Returns if the line starting at p is a section header line.
+static int lsml_is_header_line(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p >= end) return 0;
+    if (*p == '{') return p+1 >= end || p[1] != '}';
+    if (*p == '[') return p+1 >= end || p[1] != ']';
+    return 0;
+}
+
+// Finds the start of the next section header line, starting with the line at p.
+// p must be at the start of a line. Returns end if there are no more section headers.
+static const char *lsml_find_header_line(const char *p, const char *end) {
+    while (p < end) {
+        if (lsml_is_header_line(p, end)) return p;
+        p = (const char *) memchr(p, '\n', (size_t)(end - p));
+        if (p == NULL) return end;
+        p++;
+    }
+    return end;
+}
+
+static size_t lsml_count_newlines(const char *p, const char *end) {
+    size_t n = 0;
+    while (p < end) {
+        p = (const char *) memchr(p, '\n', (size_t)(end - p));
+        if (p == NULL) break;
+        n++;
+        p++;
+    }
+    return n;
+}
+
+// -- Lazy Parsing
+//
+// Only section header lines are parsed up front, found by jumping from newline to newline.
+// Each section remembers where its body is, and the body is parsed the first time the section is retrieved.
+
+// Parses the body of a section found by lsml_parse_lazy.
+static lsml_err_t lsml_section_load(lsml_data_t *data, lsml_section_t *section) {
+    lsml_parser_t parser = {0};
+    lsml_parser_set_input(&parser, section->lazy_body, section->lazy_len);
+    parser.line = section->lazy_line;
+    parser.section = section;
+    parser.log_err = data->err_log;
+    parser.log_err_userdata = data->err_log_userdata;
+    section->lazy_body = NULL; // the body is only parsed once, even if it fails
+    return lsml_parse_lines(data, &parser, LSML_PARSE_ALL);
+}
+
+lsml_err_t lsml_parse_lazy(lsml_data_t *data, const char *buf, size_t len, lsml_parse_options_t options) {
+    lsml_parser_t parser = {0};
+    const char *end = buf + len;
+    const char *header, *body, *next_header;
+    lsml_err_t err;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (buf == NULL || len == 0) return LSML_OK; // nothing to read
+    data->err_log = options.err_log;
+    data->err_log_userdata = options.err_log_userdata;
+    parser.line = 1;
+    parser.log_err = options.err_log;
+    parser.log_err_userdata = options.err_log_userdata;
+    // text before the first section header has no section, so it is parsed right away to log its errors
+    header = lsml_find_header_line(buf, end);
+    lsml_parser_set_input(&parser, buf, (size_t)(header - buf));
+    err = lsml_parse_lines(data, &parser, options);
+    if (err) return err;
+    while (header < end) {
+        body = (const char *) memchr(header, '\n', (size_t)(end - header));
+        body = body ? body + 1 : end;
+        next_header = lsml_find_header_line(body, end);
+        // parse just the header line, which creates the section
+        lsml_parser_set_input(&parser, header, (size_t)(body - header));
+        err = lsml_parse_lines(data, &parser, options);
+        if (err || parser.done) return err;
+        if (parser.section == NULL && data->n_sections == 0) {
+            // the body of a skipped section is text outside of any section, so log its errors now
+            lsml_parser_set_input(&parser, body, (size_t)(next_header - body));
+            err = lsml_parse_lines(data, &parser, options);
+            if (err) return err;
+        } else {
+            if (parser.section && next_header > body) {
+                parser.section->lazy_body = body;
+                parser.section->lazy_len = (size_t)(next_header - body);
+                parser.section->lazy_line = parser.line;
+            }
+            parser.line += (lsml_index_t) lsml_count_newlines(body, next_header);
+        }
+        header = next_header;
+    }
+    return LSML_OK;
+}
+
+// -- Parallel Parsing
+//
+// The input is split into parts at section header lines, since each line is parsed independently of the lines before it,
+// and every section header starts a fresh section.
+// The first part is parsed directly into the data on the calling thread.
+// Every other part is parsed in place by a worker into its own scratch data, recording errors and section headers as events.
+// Afterwards, the calling thread replays the events of each part in order, merging sections and logging errors,
+// so the result and the logged errors are the same as parsing the whole input in one go.
+
+typedef struct lsml_parse_worker_t {
+    char *start; // start of the part, always at a section header line
+    char *end;
+    lsml_data_t *data; // scratch data
+    lsml_parse_events_t events;
+    lsml_parse_options_t options;
+    size_t n_lines; // number of newlines in the part
+    lsml_err_t err;
+#ifdef LSML_THREADS
+    #if defined(_WIN32) || defined(_WIN64)
+    HANDLE thread;
+    #else
+    pthread_t thread;
+    #endif
+    int started;
+#endif
+} lsml_parse_worker_t;
+
+static void lsml_parse_worker_run(lsml_parse_worker_t *worker) {
+    lsml_parser_t parser = {0};
+    lsml_string_t src;
+    src.str = worker->start;
+    src.len = (size_t)(worker->end - worker->start);
+    parser.reader = lsml_reader_from_string(&src);
+    parser.src = worker->start;
+    parser.src_end = worker->end;
+    // The buffer stays untouched until the merge, so a failed part can be parsed again
+    parser.defer_terminators = 1;
+    parser.events = &worker->events;
+    parser.line = 1;
+    worker->err = lsml_parse_internal(worker->data, &parser, worker->options);
+    worker->n_lines = lsml_count_newlines(worker->start, worker->end);
+}
+
+#ifdef LSML_THREADS
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI lsml_parse_worker_main(LPVOID arg) {
+    lsml_parse_worker_run((lsml_parse_worker_t *) arg);
+    return 0;
+}
+
+static int lsml_parse_worker_start(lsml_parse_worker_t *worker) {
+    worker->thread = CreateThread(NULL, 0, lsml_parse_worker_main, worker, 0, NULL);
+    return worker->thread != NULL;
+}
+
+static void lsml_parse_worker_join(lsml_parse_worker_t *worker) {
+    WaitForSingleObject(worker->thread, INFINITE);
+    CloseHandle(worker->thread);
+}
+#else
+static void *lsml_parse_worker_main(void *arg) {
+    lsml_parse_worker_run((lsml_parse_worker_t *) arg);
+    return NULL;
+}
+
+static int lsml_parse_worker_start(lsml_parse_worker_t *worker) {
+    return pthread_create(&worker->thread, NULL, lsml_parse_worker_main, worker) == 0;
+}
+
+static void lsml_parse_worker_join(lsml_parse_worker_t *worker) {
+    pthread_join(worker->thread, NULL);
+}
+#endif
+#endif
+
+// Moves a string from a worker into the data.
+// Strings in the worker's scratch data are copied, strings in the source are null-terminated and used in place.
+static lsml_err_t lsml_parse_worker_take_string(lsml_data_t *data, const lsml_parse_worker_t *worker, lsml_string_t string, lsml_reg_str_t **reg_str) {
+    int in_source = !lsml_data_owns_ptr(worker->data, string.str);
+    if (in_source) ((char *) string.str)[string.len] = 0; // the byte after the string was already parsed
+    return lsml_data_register_string(data, string.str, string.len, in_source, reg_str);
+}
+
+// Copies a section parsed by a worker into the data, which must not already have a section with the same name.
+static lsml_err_t lsml_parse_worker_merge_section(lsml_data_t *data, const lsml_parse_worker_t *worker, const lsml_section_t *worker_section) {
+    lsml_iter_t iter = {0};
+    lsml_section_t *section;
+    lsml_section_type_t type;
+    lsml_string_t name, key, value;
+    lsml_reg_str_t *reg_key, *reg_value;
+    lsml_err_t err;
+    lsml_section_info(worker_section, &name, &type, NULL);
+    err = lsml_parse_worker_take_string(data, worker, name, &reg_key);
+    if (err) return err;
+    err = lsml_data_add_section_internal(data, reg_key, type, &section);
+    if (err) return err;
+    section->uninterned = worker_section->uninterned;
+    if (type == LSML_TABLE) {
+        while (lsml_table_next(worker_section, &iter, &key, &value)) {
+            err = lsml_parse_worker_take_string(data, worker, key, &reg_key);
+            if (err) return err;
+            err = lsml_parse_worker_take_string(data, worker, value, &reg_value);
+            if (err) return err;
+            err = lsml_table_add_entry_internal(data, section, reg_key, reg_value);
+            if (err) return err;
+        }
+    } else {
+        size_t row, col;
+        lsml_string_t stored;
+        while (lsml_array_next_2d(worker_section, &iter, &value, &row, &col)) {
+            int in_source = !lsml_data_owns_ptr(worker->data, value.str);
+            if (in_source) ((char *) value.str)[value.len] = 0; // the byte after the string was already parsed
+            err = lsml_array_store_value(data, section, &value, in_source, &stored);
+            if (err) return err;
+            err = lsml_array_add_entry_internal(data, section, &stored, col == 0);
+            if (err) return err;
+        }
+    }
+    return LSML_OK;
+}
+
+// Replays a worker's events into the data, as if the worker's part was parsed directly into the data.
+// `line` is the line number at the start of the part.
+static lsml_err_t lsml_parse_worker_merge(lsml_data_t *data, const lsml_parse_worker_t *worker, lsml_index_t line, lsml_parse_options_t options) {
+    int skip_errors = 0; // set after a section is skipped because its name is reused
+    for (size_t i = 0; i < worker->events.n_events; i++) {
+        const lsml_parse_event_t *event = worker->events.events + i;
+        lsml_index_t event_line = line + event->line - 1;
+        lsml_err_t log_err = LSML_OK;
+        switch (event->type) {
+            case LSML_EVENT_HEADER: skip_errors = 0; break;
+            case LSML_EVENT_SECTION: {
+                lsml_string_t name;
+                if (event->section == NULL) break;
+                lsml_section_info(event->section, &name, NULL, NULL);
+                if (lsml_data_get_section(data, LSML_ANYSECTION, name.str, name.len, NULL, NULL) == LSML_OK) {
+                    // the section was already parsed from an earlier part, so it is skipped along with its errors
+                    log_err = LSML_ERR_SECTION_NAME_REUSED;
+                    skip_errors = 1;
+                } else {
+                    lsml_err_t err = lsml_parse_worker_merge_section(data, worker, event->section);
+                    if (err) return err;
+                }
+            } break;
+            default: {
+                if (skip_errors) break;
+                // the worker does not know about sections from earlier parts
+                if (event->err == LSML_ERR_TEXT_OUTSIDE_SECTION && data->n_sections != 0) break;
+                log_err = event->err;
+            } break;
+        }
+        if (log_err && options.err_log && options.err_log(options.err_log_userdata, log_err, event_line)) return LSML_ERR_PARSE_ABORTED;
+    }
+    return LSML_OK;
+}
+
+lsml_err_t lsml_parse_parallel(lsml_data_t *data, char *buf, size_t len, lsml_parse_options_t options, void *scratch, size_t scratch_size, unsigned int n_threads) {
+    lsml_parse_worker_t workers[LSML_MAX_THREADS];
+    size_t n_workers, worker_size;
+    char *first_end;
+    lsml_index_t line;
+    lsml_err_t err;
+    if (data == NULL || data->frozen) return LSML_ERR_INVALID_DATA;
+    if (buf == NULL || len == 0) return LSML_OK; // nothing to read
+    if (n_threads > LSML_MAX_THREADS) n_threads = LSML_MAX_THREADS;
+    // The calling thread parses the first part, so it isn't counted as a worker
+    n_workers = n_threads > 1 ? n_threads - 1 : 0;
+    // Align the scratch memory for the workers' datas
+    if (scratch) {
+        size_t misalign = (size_t)((uintptr_t)scratch % sizeof(lsml_max_align_t));
+        if (misalign) {
+            size_t skip = sizeof(lsml_max_align_t) - misalign;
+            scratch = (char *)scratch + skip;
+            scratch_size = scratch_size > skip ? scratch_size - skip : 0;
+        }
+    } else {
+        scratch_size = 0;
+    }
+    worker_size = n_workers ? (scratch_size / n_workers) & ~(sizeof(lsml_max_align_t)-1) : 0;
+    // Limiting the number of sections depends on the order sections are parsed in, so only parse serially
+    if (options.n_sections != 0 || worker_size < 2*sizeof(lsml_data_t) + 1024) n_workers = 0;
+
+    // Split the input into parts at section header lines
+    first_end = buf + len;
+    {
+        const char *part_end = buf + len;
+        size_t n_parts = 0;
+        for (size_t i = 0; i < n_workers; i++) {
+            // start searching for a section header from the line containing the target split point
+            const char *target = buf + (len / (n_workers+1)) * (i+1);
+            const char *prev_end = n_parts ? workers[n_parts-1].start : buf;
+            const char *start;
+            if (target < prev_end) target = prev_end;
+            while (target > buf && target[-1] != '\n') target--;
+            if (target <= prev_end && n_parts) {
+                // don't start on the same header as the previous part
+                target = (const char *) memchr(target, '\n', (size_t)(part_end - target));
+                if (target == NULL) break;
+                target++;
+            }
+            start = lsml_find_header_line(target, part_end);
+            if (start >= part_end || (n_parts == 0 && start == buf)) continue;
+            workers[n_parts].start = buf + (start - buf);
+            n_parts++;
+        }
+        n_workers = n_parts;
+    }
+    if (n_workers) first_end = workers[0].start;
+    for (size_t i = 0; i < n_workers; i++) {
+        lsml_parse_worker_t *worker = workers + i;
+        char *worker_mem = (char *) scratch + i*worker_size;
+        size_t events_size = (worker_size / 8) & ~(sizeof(lsml_max_align_t)-1);
+        worker->end = (i+1 < n_workers) ? workers[i+1].start : buf + len;
+        worker->events.events = (lsml_parse_event_t *) worker_mem;
+        worker->events.n_events = 0;
+        worker->events.cap = events_size / sizeof(lsml_parse_event_t);
+        worker->data = lsml_data_new(worker_mem + events_size, worker_size - events_size);
+        worker->options = options;
+        worker->options.err_log = NULL;
+        worker->n_lines = 0;
+        worker->err = worker->data ? LSML_OK : LSML_ERR_OUT_OF_MEMORY;
+#ifdef LSML_THREADS
+        worker->started = worker->data && lsml_parse_worker_start(worker);
+#endif
+    }
+#ifndef LSML_THREADS
+    for (size_t i = 0; i < n_workers; i++) {
+        if (workers[i].data) lsml_parse_worker_run(workers + i);
+    }
+#endif
+
+    // Parse the first part on this thread while the workers run, and then merge the rest in order
+    {
+        lsml_parser_t parser = {0};
+        lsml_string_t src;
+        src.str = buf;
+        src.len = (size_t)(first_end - buf);
+        parser.reader = lsml_reader_from_string(&src);
+        parser.src = buf;
+        parser.src_end = first_end;
+        parser.line = 1;
+        // null terminators may be written over newlines, so count them first
+        line = (lsml_index_t)(1 + lsml_count_newlines(buf, first_end));
+        err = lsml_parse_internal(data, &parser, options);
+#ifdef LSML_THREADS
+        for (size_t i = 0; i < n_workers; i++) {
+            if (workers[i].started) lsml_parse_worker_join(workers + i);
+            else if (workers[i].data) lsml_parse_worker_run(workers + i);
+        }
+#endif
+        if (err) return err;
+        for (size_t i = 0; i < n_workers; i++) {
+            lsml_parse_worker_t *worker = workers + i;
+            if (worker->err == LSML_OK) {
+                err = lsml_parse_worker_merge(data, worker, line, options);
+            } else {
+                // the worker ran out of memory, so parse its part again directly
+                lsml_parser_t retry = {0};
+                src.str = worker->start;
+                src.len = (size_t)(worker->end - worker->start);
+                retry.reader = lsml_reader_from_string(&src);
+                retry.src = worker->start;
+                retry.src_end = worker->end;
+                retry.line = line;
+                worker->n_lines = lsml_count_newlines(worker->start, worker->end);
+                err = lsml_parse_internal(data, &retry, options);
+            }
+            if (err) return err;
+            line += (lsml_index_t) worker->n_lines;
+        }
+    }
+    return LSML_OK;
+}
+
 
 // --- Value Interpreting
 
@@ -42,6 +42,12 @@ typedef struct lsml_string_t {
     size_t len; // Length of the string
 } lsml_string_t;
 
+// A row of an array, as a span of its values.
+typedef struct lsml_array_span_t {
+    size_t start; // Index of the row's first value in the array
+    size_t len; // Number of values in the row
+} lsml_array_span_t;
+
 
 // -- Opaque types
 
@@ -51,6 +57,9 @@ typedef struct lsml_data_t lsml_data_t;
 // Stores information about a section of LSML data, either as a table or an array.
 typedef struct lsml_section_t lsml_section_t;
 
+// Stores the state of a parser which is fed input as it arrives.
+typedef struct lsml_parser_t lsml_parser_t;
+
 // Stores information about iteration.
 // Initialize to zero to start iterating.
 // NOTE: only use with one iteration function!
@@ -58,6 +67,7 @@ typedef struct lsml_iter_t {
     void *chunk;
     void *elem;
     size_t index;
+    size_t row;
 } lsml_iter_t;
 
 // -- Enums
@@ -121,6 +131,11 @@ typedef struct lsml_parse_options_t {
     
     lsml_parse_err_log_fn err_log; // Error logging function
     void *err_log_userdata; // Data to be passed to the error logging function
+
+    // Decides for each array section if its values are interned (see lsml_array_set_interning), NULL=intern every array
+    // Table keys, table values and section names are always interned.
+    lsml_parse_condition_fn intern_arrays;
+    void *intern_arrays_userdata; // Data to be passed to the intern function
 } lsml_parse_options_t;
 #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
 static const lsml_parse_options_t LSML_PARSE_ALL = {.n_sections=0};
@@ -134,11 +149,31 @@ static const lsml_parse_options_t LSML_PARSE_ONE = {1};
 typedef struct lsml_reader_t {
     // Reads a single byte from the reader, returning a value from 0-255 (inclusive) if successful.
     // Returns a negative number if EOF has been reached or the read failed.
+    // Only used if read_block is NULL, in which case it is called for each byte as the parser needs it.
     int (*read)(void *userdata);
-    // Data given to the read function, usually tracks reader state.
+    // Data given to the read functions, usually tracks reader state.
     void *userdata;
+    // Reads a block of bytes from the reader, returning the number of bytes in the block.
+    // Returns 0 if EOF has been reached or the read failed.
+    // The reader can either:
+    // - Fill `buf` with up to `buf_size` bytes and set `*block` to `buf`
+    // - Lend its own memory by setting `*block` to it, which must stay valid until the next call
+    // Optional: if NULL, the parser falls back to calling `read` once per byte.
+    size_t (*read_block)(void *userdata, char *buf, size_t buf_size, const char **block);
 } lsml_reader_t;
 
+// Allocates memory for a growable data (see lsml_data_new_growable), returning NULL if it fails.
+// The memory must be aligned for any type, like memory from malloc.
+typedef void *(*lsml_alloc_fn)(void *userdata, size_t size);
+// Frees memory from lsml_alloc_fn, with the same size it was allocated with.
+typedef void (*lsml_free_fn)(void *userdata, void *ptr, size_t size);
+
+typedef struct lsml_allocator_t {
+    lsml_alloc_fn alloc; // Allocates blocks, or NULL to use malloc and free
+    lsml_free_fn free; // Frees blocks, or NULL to never free them
+    void *userdata; // Data to be passed to the allocator's functions
+} lsml_allocator_t;
+
 // Built-in parse filters
 
 // Populates given parse options with userdata and condition such that
@@ -146,6 +181,10 @@ typedef struct lsml_reader_t {
 // Returns INVALID_DATA if either pointer is NULL.
 LSML_API lsml_err_t lsml_parse_condition_sections_match(lsml_parse_options_t *options, lsml_data_t *template);
 
+// Intern function which stores the values of every array on their own, for the intern_arrays option.
+// Suits arrays of mostly unique values, like IDs, timestamps, or measurements.
+LSML_API int lsml_parse_intern_none(void *userdata, lsml_string_t section_name, lsml_section_type_t section_type);
+
 
 
 // --- Strings
@@ -164,13 +203,31 @@ LSML_API lsml_string_t lsml_string_init(const char *str, size_t len);
 // If creation succeeds, the data's pointer is returned. Otherwise, the NULL pointer is returned.
 LSML_API lsml_data_t *lsml_data_new(void *buf, size_t size);
 
+// Creates a new lsml data storage which grows by chaining blocks of memory from an allocator when it is full.
+// Each block is twice as large as the last, starting with `initial_size` bytes.
+// Pointers from the data stay valid as it grows, until the data is freed with lsml_data_free.
+// If creation succeeds, the data's pointer is returned. Otherwise, the NULL pointer is returned.
+LSML_API lsml_data_t *lsml_data_new_growable(lsml_allocator_t allocator, size_t initial_size);
+
+// Frees every block of a growable data, including the data itself.
+// Does nothing if the data is NULL or was not created by lsml_data_new_growable.
+LSML_API void lsml_data_free(lsml_data_t *data);
+
+// Sets the seed of the data's string hashes, which must be done before anything is added to it.
+// By default, the seed is derived from the data's address, which varies between runs if the system randomizes addresses.
+// Setting the seed makes hashes, and so the placement of entries in memory, repeatable, but makes collisions easier to craft for untrusted input.
+// Returns INVALID_DATA if the data is NULL or not empty.
+LSML_API lsml_err_t lsml_data_set_seed(lsml_data_t *data, uint64_t seed);
+
 // Gets the data's internal buffer and associated size.
+// For growable datas, this is the block which is currently being allocated from.
 // `buf_size` is an optional pointer to be populated with the buffer size.
 LSML_API void *lsml_data_buffer(lsml_data_t *data, size_t *buf_size);
 
 // Resets the contents of the data to just after LSML_DATA_NEW.
 // Any pointers to content from this data, including strings, sections, and iterators, are invalid after calling this.
 // It is not necessary to call this to free a data's buffer, since the data performed no additional allocation.
+// Growable datas free every block except the one holding the data, which is their first unless it was compacted in place.
 // Does nothing if the data is NULL.
 LSML_API void lsml_data_clear(lsml_data_t *data);
 
@@ -180,19 +237,174 @@ LSML_API size_t lsml_data_mem_usage(const lsml_data_t *data);
 // Retrieves the number of sections stored within the data.
 LSML_API size_t lsml_data_section_count(const lsml_data_t *data);
 
-// Copies values from one data to another.
-// Any conflicting keys are resolved by the `overwrite_conflicts` parameter.
-// - If true, any sections, key-value pairs, or array entries will replace entries in dest.
-// - If false, any of those values remain the same in dest, and the corresponding src values are ignored.
+// Copies the sections of one data into another, after dest's sections, in the order they were added to src.
+// A section of src whose name is already in dest conflicts with it, unless both are tables, which are merged:
+// a key of src's table conflicts with the same key in dest's, and other keys are added after dest's.
+// Any conflicts are resolved by the `overwrite_conflicts` parameter.
+// - If true, src's sections and values replace dest's, and keep the place of the ones they replace.
+// - If false, dest's sections and values remain the same, and the corresponding src sections and values are ignored.
+// Arrays copied from src store their values on their own if src's did (see lsml_array_set_interning).
+// Each string of src is hashed once, however many times it is used, and tables make room for src's entries up front.
+// Returns INVALID_DATA if either data is NULL or dest is frozen. If dest runs out of memory, it keeps what was copied.
+// src is unchanged, except that any sections which were not parsed yet are parsed.
 // 
 // NOTE: this appends to dest, so call `lsml_data_clear(dest)` first if you want no conflicts.
 LSML_API lsml_err_t lsml_data_copy(lsml_data_t *dest, const lsml_data_t *src, int overwrite_conflicts);
 
+// Copies a data into the provided memory block, leaving behind the memory it no longer uses:
+// strings of values which were replaced or removed, slots of tables which grew or had entries removed,
+// and anything else abandoned as the data was parsed and changed.
+// The compacted data has the same sections and values in the same order, and hashes and logs errors like src.
+// n_reclaimed stores how many fewer bytes the compacted data uses than src, and is optional.
+// src is unchanged, except that any sections which were not parsed yet are parsed.
+// If compacting succeeds, the compacted data's pointer is returned.
+// Returns NULL if src is NULL, or if dst_size is too small for the compacted data.
+LSML_API lsml_data_t *lsml_data_compact(const lsml_data_t *src, void *dst_buf, size_t dst_size, size_t *n_reclaimed);
+
+// Compacts a data like lsml_data_compact, but back into its own memory.
+// A growable data is compacted into a temporary data from its allocator, and then takes over that data's blocks,
+// giving back every block of its own but the one holding it.
+// A fixed data is compacted into its own free memory, so that must hold the compacted data as well,
+// and is then copied back to the start of its memory the same way, which is only done once that is known to fit.
+// If the compacted data would not be any smaller, the data is left as it is and n_reclaimed is 0.
+// Otherwise, any pointers to content from this data, including strings, sections, and iterators, are invalid after calling this.
+// n_reclaimed stores how many fewer bytes the data uses, and is optional.
+// Returns INVALID_DATA if the data is NULL or frozen.
+// Returns OUT_OF_MEMORY if the data's free memory or allocator has no room for the temporary compacted copy,
+// and leaves the data unchanged.
+LSML_API lsml_err_t lsml_data_compact_in_place(lsml_data_t *data, size_t *n_reclaimed);
+
+// Gets the exact size of the buffer needed to freeze a data with lsml_data_freeze.
+// Any sections of src which were not parsed yet (see lsml_parse_lazy) are parsed first.
+// Returns 0 if src is NULL or frozen, or if the frozen data would need more than 4 GiB (see lsml_data_freeze).
+LSML_API size_t lsml_data_freeze_size(const lsml_data_t *src);
+
+// Rebuilds a data into a compact layout for reading, using the provided memory block, which can't be changed after.
+// The frozen data has sections, strings, and values stored one after another, with no room to grow.
+// Its section names and the keys of its tables are placed by a minimal perfect hash,
+// so looking one up compares exactly one name or key, without probing.
+// It holds no pointers, only 32 bit offsets from the data, which starts dst_buf, so it can be copied or mapped anywhere.
+// Strings read from it are still lsml_string_t, pointing into wherever its memory is.
+// It is read like any other data, but adding to it or parsing into it returns INVALID_DATA.
+// Clearing a frozen data makes it writable again, if its buffer has room for an empty data.
+// src is unchanged, except that any sections which were not parsed yet are parsed.
+// If freezing succeeds, the frozen data's pointer is returned.
+// Returns NULL if src is NULL or frozen, or if dst_size is less than lsml_data_freeze_size, or if that is 0.
+// Returns NULL if two section names or two keys of a table have the same 64 bit hash, which no perfect hash can separate.
+LSML_API lsml_data_t *lsml_data_freeze(const lsml_data_t *src, void *dst_buf, size_t dst_size);
+
+// Opens a copy of a frozen data's memory, returning the data in the copy, which is at its start.
+// A frozen data holds no pointers, so the copy is usable as it is, and this only checks it, without writing to it.
+// buf and size must be a copy of the dst_buf and dst_size given to lsml_data_freeze, aligned like any data.
+// The copy must come from lsml_data_freeze, since it is trusted to be a valid frozen data.
+// Returns NULL if buf is NULL, misaligned, or does not hold a frozen data of the given size.
+LSML_API lsml_data_t *lsml_data_relocate(void *buf, size_t size);
+
+// Size of the header at the start of a snapshot.
+#define LSML_SNAPSHOT_HEADER_SIZE 64
+
+// Writes the header of a snapshot of a frozen data to header, which holds LSML_SNAPSHOT_HEADER_SIZE bytes.
+// A snapshot is this header followed by the frozen data's whole buffer (see lsml_data_buffer),
+// which is saved by lsml_data_save_snapshot in lsml_io.h.
+// The header holds a version, the byte order and type sizes of this build, and checksums of itself and the buffer.
+// The data holds no pointers, so nothing depends on where it was frozen or where the snapshot is opened.
+// Freeze with exactly lsml_data_freeze_size bytes to keep snapshots small, since the whole buffer is saved.
+// Returns INVALID_DATA if the data is NULL or not frozen.
+// Returns VALUE_NULL if header is NULL.
+LSML_API lsml_err_t lsml_data_snapshot_header(const lsml_data_t *data, unsigned char *header);
+
+// Reads the header of a snapshot, before the rest of it is loaded or mapped into memory.
+// snapshot_len stores the length of the whole snapshot, and is optional.
+// Returns INVALID_DATA if the header is not from this version of LSML with the same byte order and type sizes,
+// or if its checksum doesn't match.
+LSML_API lsml_err_t lsml_snapshot_info(const unsigned char *header, size_t *snapshot_len);
+
+// Opens a snapshot which was loaded or mapped into memory, returning the data inside it without parsing anything.
+// Only the header is checked, and nothing is written, so opening costs the same for any size of snapshot
+// (see lsml_data_relocate). The snapshot must be aligned like any data, less LSML_SNAPSHOT_HEADER_SIZE.
+// Returns NULL if the header is not from this version of LSML with the same byte order and type sizes,
+// if its checksum or size don't match, or if the snapshot is misaligned.
+// The snapshot's contents are trusted, so only open snapshots this program saved.
+// To catch snapshots which were damaged on disk, check them with lsml_snapshot_verify before opening them.
+LSML_API lsml_data_t *lsml_data_open_snapshot(void *snapshot, size_t snapshot_len);
+
+// Opens a snapshot like lsml_data_open_snapshot, at any address, returning the data as read-only.
+// Nothing is written, so the snapshot may be in read-only memory, such as a file mapped with PROT_READ,
+// and this only checks the header, whatever the size of the snapshot.
+// Returns NULL in the same cases as lsml_data_open_snapshot.
+LSML_API const lsml_data_t *lsml_data_open_snapshot_readonly(const void *snapshot, size_t snapshot_len);
+
+// Checks a snapshot's header like lsml_data_open_snapshot, and checks its contents against their checksum.
+// This reads the whole snapshot, so it costs more than opening it.
+// Returns INVALID_DATA if the snapshot does not pass.
+LSML_API lsml_err_t lsml_snapshot_verify(const void *snapshot, size_t snapshot_len);
+
 
 // Parses the output of a reader into lsml data until the reader stops.
 // Existing information in the data is kept, and newly parsed sections are added.
 LSML_API lsml_err_t lsml_parse(lsml_data_t *data, lsml_reader_t reader, lsml_parse_options_t options);
 
+// Measures how much memory parsing the output of a reader into a new data takes, without building anything.
+// Creating a data with at least `*bytes_needed` bytes of memory and parsing the same input never runs out of memory.
+// - The condition and n_sections options are used like when parsing, but errors are not logged.
+// - The result is exact for input without repeated strings (with the most padding strings may need),
+//   and an upper bound otherwise, since repeated strings and entries are only stored once.
+// Returns VALUE_NULL if bytes_needed is NULL.
+LSML_API lsml_err_t lsml_parse_measure(lsml_reader_t reader, lsml_parse_options_t options, size_t *bytes_needed);
+
+// Parses a caller-owned buffer into lsml data without copying most strings.
+// Unquoted strings and quoted strings without escapes point directly into the buffer,
+// and only escaped strings, section references, and strings at the very end of the buffer are copied into the data.
+// - The buffer is modified: a null terminator is written over the delimiter or whitespace right after each referenced string.
+//   A private, writable memory map of a file works as well.
+// - The buffer must exist longer than the data, and must not be modified after parsing.
+// Otherwise, this behaves exactly like lsml_parse.
+LSML_API lsml_err_t lsml_parse_in_place(lsml_data_t *data, char *buf, size_t len, lsml_parse_options_t options);
+
+// Parses a caller-owned buffer in place like lsml_parse_in_place, using up to n_threads threads (including the calling thread).
+// The buffer is split at section headers, and each part after the first is parsed into a slice of the scratch memory.
+// Sections are then merged into the data in order, so the result and the logged errors (and their line numbers)
+// are the same as with lsml_parse_in_place.
+// - The scratch memory should be about as large as the memory the parsed data will take, and is unused after this returns.
+// - The condition may be called from several threads at once, but err_log is only called from the calling thread.
+// - If n_sections is nonzero or the scratch memory is too small, this behaves exactly like lsml_parse_in_place.
+// - If the library was built without LSML_THREADS, the parts are parsed one after another on the calling thread.
+LSML_API lsml_err_t lsml_parse_parallel(lsml_data_t *data, char *buf, size_t len, lsml_parse_options_t options, void *scratch, size_t scratch_size, unsigned int n_threads);
+
+// Parses only the section headers of a buffer up front, such as a memory-mapped file.
+// Each section's body is parsed the first time the section is retrieved with lsml_data_get_section,
+// lsml_data_get_sections, or lsml_data_next_section, so unused sections cost little more than their header line.
+// - The buffer is not modified, and must exist until every section was retrieved (or longer than the data, to be safe).
+// - The condition and n_sections options apply to section headers as usual.
+// - Errors in a section's body are logged with err_log when the section is parsed, with the right line numbers.
+//   The error log options are kept in the data for this, so the userdata must exist as long as the data.
+// - Retrieving a section which is not parsed yet modifies the data, so this is not thread safe.
+// - If parsing a section's body fails (out of memory or aborted), lsml_data_get_section returns the error,
+//   and the section is left with only the entries parsed before the failure.
+// Otherwise, the result is the same as lsml_parse.
+LSML_API lsml_err_t lsml_parse_lazy(lsml_data_t *data, const char *buf, size_t len, lsml_parse_options_t options);
+
+// Returns the size of memory needed by lsml_parser_new to handle lines up to max_line_len bytes long.
+LSML_API size_t lsml_parser_mem_size(size_t max_line_len);
+
+// Creates a parser which parses input into the data as it is fed, using the provided memory block with fixed size.
+// The parser keeps its state between feeds, so input can be fed in any sized pieces, such as reads from a socket.
+// - The memory holds the parser and the start of a line which was not completely fed yet,
+//   so it limits the length of lines split between feeds (see lsml_parser_mem_size).
+// - The parser performs no additional allocation, so it does not need to be freed.
+// If creation succeeds, the parser's pointer is returned. Otherwise, the NULL pointer is returned.
+LSML_API lsml_parser_t *lsml_parser_new(void *buf, size_t size, lsml_data_t *data, lsml_parse_options_t options);
+
+// Parses a piece of input. Every complete line is parsed before this returns, and the rest is kept for the next feed.
+// The fed buffer is not used after this returns.
+// Returns OUT_OF_MEMORY if a line split between feeds does not fit in the parser's memory.
+// After an error, the parser is stopped, and every following feed returns the same error.
+LSML_API lsml_err_t lsml_parser_feed(lsml_parser_t *parser, const char *buf, size_t len);
+
+// Parses the rest of the input, which is a line without a newline at the end.
+// Call this after feeding all input, to get the same result as lsml_parse.
+LSML_API lsml_err_t lsml_parser_finish(lsml_parser_t *parser);
+
 
 
 // -- Sections
@@ -218,6 +430,7 @@ LSML_API lsml_err_t lsml_data_get_section(const lsml_data_t *data, lsml_section_
 LSML_API lsml_err_t lsml_data_get_sections(const lsml_data_t *data, lsml_section_type_t desired_type, lsml_section_t **sections, size_t n_sections, size_t *n_sections_avail);
 
 // Gets the next section in the data, overwriting the data in the pointers.
+// Sections are visited in the order they were added, which is the order of the parsed text.
 // iter is required, but section and section_type are optional.
 // The given iterator must be initialized to 0 to start the iteration.
 // The resulting section is set to NULL when iteration ends, but the iterator will still be populated (nonzero).
@@ -260,7 +473,28 @@ LSML_API lsml_err_t lsml_table_get(const lsml_section_t *table, const char *key_
 // Returns TABLE_KEY_REUSED if there is already an entry with the given key.
 LSML_API lsml_err_t lsml_table_add_entry(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len, const char *value, size_t value_len);
 
+// Sets the value of a key in the table associated with data, adding an entry after the others if the key isn't present.
+// Strings read from the table before stay valid until the data is cleared, including the old value.
+// Returns INVALID_DATA if the data is not usable or frozen.
+// Returns INVALID_SECTION if the section is not usable.
+// Returns SECTION_TYPE if the section is not a table.
+// Returns INVALID_KEY if the string is not given or empty.
+// Returns VALUE_NULL if the value is not given.
+// Returns OUT_OF_MEMORY if there is not enough space for the value or the new entry.
+LSML_API lsml_err_t lsml_table_set(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len, const char *value, size_t value_len);
+
+// Removes an entry from the table associated with data, taking constant time on average.
+// Adding the key again puts it after the other entries. Strings read from the table stay valid until the data is cleared.
+// The table reuses the memory of removed entries once enough of them pile up, so an iteration which
+// adds entries after removing some may skip or repeat entries, and must start over.
+// Returns INVALID_DATA if the data is not usable or frozen.
+// Returns INVALID_SECTION if the section is not usable.
+// Returns SECTION_TYPE if the section is not a table.
+// Returns NOT_FOUND if key_name is empty or not present.
+LSML_API lsml_err_t lsml_table_remove(lsml_data_t *data, lsml_section_t *table, const char *key_name, size_t key_len);
+
 // Gets the next key-value pair from the table, overwriting the data in the pointers.
+// Entries are visited in the order they were added, which is the order of the parsed text.
 // Returns if iteration continued. If so, both key and value are modified to contain the next values, if they are present.
 // iter is required, but key and value are optional.
 // The given iterator must be initialized to 0 to start the iteration.
@@ -273,8 +507,8 @@ LSML_API int lsml_table_next(const lsml_section_t *table, lsml_iter_t *iter, lsm
 // Calculates the 2D dimensions of the array.
 // - If is_jagged is false, then cols will be set to the minimum column count of all rows.
 // - If is_jagged is true, then cols will be set to the maximum column count of all rows.
-// 
-// NOTE: This must iterate through all rows to find the max or min column size, so don't use this function recklessly!
+// The column counts of all rows are kept up to date as values are pushed, so this takes constant time.
+// An array with no values has no rows.
 // Returns INVALID_SECTION if the section is NULL.
 // Returns ERR_SECTION_TYPE if the section is not an array.
 LSML_API lsml_err_t lsml_array_2d_size(const lsml_section_t *array, int is_jagged, size_t *rows, size_t *cols);
@@ -293,13 +527,27 @@ LSML_API lsml_err_t lsml_array_get(const lsml_section_t *array, size_t index, ls
 // Returns NOT_FOUND if the row or column is out of bounds.
 LSML_API lsml_err_t lsml_array_get_2d(const lsml_section_t *array, size_t row, size_t col, lsml_string_t *value);
 
-
+// Finds the first value in the array equal to the given value, if it exists.
+// If value_len is 0, the value is assumed to be null-terminated.
+// index stores the index of the found value, and is optional.
+// Returns INVALID_SECTION if the section is NULL.
+// Returns ERR_SECTION_TYPE if the section is not an array.
+// Returns VALUE_NULL if the value is not given.
+// Returns NOT_FOUND if no value is equal.
 LSML_API lsml_err_t lsml_array_find(const lsml_section_t *array, const char *value, size_t value_len, size_t *index);
 
+// Finds the first value in the array equal to the given value like lsml_array_find, storing its row and column.
+// row and col are optional.
 LSML_API lsml_err_t lsml_array_find_2d(const lsml_section_t *array, const char *value, size_t value_len, size_t *row, size_t *col);
 
+// Finds the first value in a row of the array equal to the given value like lsml_array_find, storing its column.
+// col is optional.
+// Returns NOT_FOUND if the row does not exist.
 LSML_API lsml_err_t lsml_array_find_in_row(const lsml_section_t *array, const char *value, size_t value_len, size_t row, size_t *col);
 
+// Finds the first value in a column of the array equal to the given value like lsml_array_find, storing its row.
+// Rows too short to have the column are skipped.
+// row is optional.
 LSML_API lsml_err_t lsml_array_find_in_col(const lsml_section_t *array, const char *value, size_t value_len, size_t *row, size_t col);
 
 // Gets multiple values from the array in a range of indices.
@@ -309,10 +557,54 @@ LSML_API lsml_err_t lsml_array_find_in_col(const lsml_section_t *array, const ch
 // Returns NOT_FOUND if the index range goes out of bounds, and does not write any data.
 LSML_API lsml_err_t lsml_array_get_many(const lsml_section_t *array, size_t start_index, size_t n_elems, lsml_string_t *values);
 
+// Gets a range of rows from the array, with the values in those rows.
+// spans represents a list of at least n_rows spans, and is modified to contain the span of each row, and is optional.
+// values stores up to n_values values of the rows, in order, and is optional.
+// n_values_avail stores how many values the rows have, and is optional.
+// Returns INVALID_SECTION if the section is NULL.
+// Returns ERR_SECTION_TYPE if the section is not an array.
+// Returns NOT_FOUND if the row range goes out of bounds, and does not write any data.
+LSML_API lsml_err_t lsml_array_get_rows(const lsml_section_t *array, size_t start_row, size_t n_rows, lsml_array_span_t *spans, lsml_string_t *values, size_t n_values, size_t *n_values_avail);
+
 // Pushes a new value onto the end of the array assocaited with data.
 // If newrow is true, the value starts a new row, otherwise the value appends to the current row.
 LSML_API lsml_err_t lsml_array_push(lsml_data_t *data, lsml_section_t *array, const char *val, size_t val_len, int newrow);
 
+// Replaces the value at an index of the array associated with data.
+// Interned values stay valid until the data is cleared, but if the array stores its values on their own
+// (see lsml_array_set_interning), the old value's memory may be reused by the next value stored.
+// Returns INVALID_DATA if the data is not usable or frozen.
+// Returns INVALID_SECTION if the section is not usable.
+// Returns SECTION_TYPE if the section is not an array.
+// Returns VALUE_NULL if the value is not given.
+// Returns NOT_FOUND if the index is out of bounds.
+// Returns OUT_OF_MEMORY if there is not enough space for the value.
+LSML_API lsml_err_t lsml_array_set(lsml_data_t *data, lsml_section_t *array, size_t index, const char *val, size_t val_len);
+
+// Removes a row from the array associated with data, moving the values after it back by the length of the row,
+// so this takes time in the number of values after it. The dimensions from lsml_array_2d_size are kept up to date
+// from a count of the rows of each width, which the first removal from an array takes time in its number of rows to make.
+// Removing the only row leaves the array with no rows. Values of the row are treated like values replaced by lsml_array_set.
+// Returns INVALID_DATA if the data is not usable or frozen.
+// Returns INVALID_SECTION if the section is not usable.
+// Returns SECTION_TYPE if the section is not an array.
+// Returns NOT_FOUND if the row does not exist.
+LSML_API lsml_err_t lsml_array_remove_row(lsml_data_t *data, lsml_section_t *array, size_t row);
+
+// Sets if values added to the array are interned with the data's strings, so a repeated value is stored once.
+// Arrays intern their values unless told otherwise. Mostly unique values are faster to add
+// and take less memory when stored on their own, since interning them finds nothing to reuse.
+// Returns INVALID_SECTION if the section is NULL, or if the array already has values, which are all stored one way.
+// Returns ERR_SECTION_TYPE if the section is not an array.
+LSML_API lsml_err_t lsml_array_set_interning(lsml_section_t *array, int intern);
+
+// Gets how many values were interned into the array, and how many of those the data already had.
+// n_reused / n_interned is the dedup hit rate, which tells if interning the array's values saves anything.
+// Both are 0 for an array which stores its values on their own.
+// Returns INVALID_SECTION if the section is NULL.
+// Returns ERR_SECTION_TYPE if the section is not an array.
+LSML_API lsml_err_t lsml_array_intern_stats(const lsml_section_t *array, size_t *n_interned, size_t *n_reused);
+
 // Gets the next value from the array, overwriting the data in the pointers.
 // Returns if iteration continued. If so, value is modified to contain the next value, if it is present.
 // iter is required, but value is optional.
@@ -335,6 +627,7 @@ LSML_API int lsml_array_next_2d(const lsml_section_t *array, lsml_iter_t *iter,
 // Creates a reader that reads from a string, incrementing the string's pointer to track progress.
 // NOTE: modifies the string's pointer and length, so keep a separate copy!
 // Reads from the string until it reaches the end, so the given pointer must exist longer than the reader.
+// The whole string is lent to the parser as a single block.
 LSML_API lsml_reader_t lsml_reader_from_string(lsml_string_t *string);
 
 
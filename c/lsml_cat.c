@@ -21,22 +21,37 @@ int can_seek(FILE *f) {
     return (fseek(f, 0, SEEK_CUR) == 0); // if no-op fails, then seeking is likely not possible
 }
 
-size_t default_mem_cap() {
-    if (sizeof(size_t) >= 8)
-        return 1024*1024*1024; // 1GiB
-    else if (sizeof(size_t) >= 4) {
-        return 128*1024*1024; // 128MiB
-    } else if (sizeof(size_t) >= 2) {
-        return 16*1024*1024; // 16MiB
+// Reads all files one after another, with a newline between them, to measure them as one.
+typedef struct files_reader_t {
+    FILE **files;
+    int n_files;
+    int i;
+    int newline; // if a newline goes before the next file
+    lsml_reader_t reader;
+} files_reader_t;
+
+size_t files_reader_read(void *userdata, char *buf, size_t buf_size, const char **block) {
+    files_reader_t *all = (files_reader_t *) userdata;
+    while (all->i < all->n_files) {
+        if (all->newline) {
+            all->newline = 0;
+            *block = "\n";
+            return 1;
+        }
+        size_t len = all->reader.read_block(all->reader.userdata, buf, buf_size, block);
+        if (len) return len;
+        all->i += 1;
+        all->newline = 1;
+        if (all->i < all->n_files) all->reader = lsml_reader_from_stream(all->files[all->i]);
     }
-    return 1024*1024; // 1MiB
+    return 0;
 }
 
 int main(int argc, const char **argv) {
     int n_files = 0;
     FILE *file = NULL;
     FILE **files;
-    size_t mem_cap = 4096;
+    int seekable = 1;
     if (argc > 1) {
         files = malloc(sizeof(FILE*)*(argc-1));
         if (files == NULL) {
@@ -48,65 +63,62 @@ int main(int argc, const char **argv) {
             file = fopen(filename, "rb");
             if (file == NULL) {
                 fprintf(stderr, "%s: %s: No such file or directory\n", argv[0], filename);
-                i -= 1;
                 continue;
             }
             files[n_files] = file;
             n_files += 1;
         }
-        // estimate memory capacity
-        for (int i = 0; i < n_files; i++) {
-            file = files[i];
-            if (!can_seek(file)) {
-                mem_cap = default_mem_cap();
-                break;
-            }
-            fseek(file, 0, SEEK_END);
-            long bytes = ftell(file);
-            if (bytes < 0) {
-                mem_cap = default_mem_cap();
-                rewind(file);
-                break;
-            }
-            rewind(file);
-            size_t new_cap = mem_cap + (32*sizeof(void*))*((size_t)bytes);
-            if (new_cap < mem_cap) { // overflow
-                fprintf(stderr, "out of memory\n");
-                return -1;
-            }
-            mem_cap = new_cap;
-        }
     } else {
-        // relying on virtual memory on 32-bit and 64-bit systems
         file = stdin;
         files = &file;
-        mem_cap = default_mem_cap();
         n_files = 1;
     }
+    for (int i = 0; i < n_files; i++) {
+        if (!can_seek(files[i])) seekable = 0;
+    }
 
-    void *mem = malloc(mem_cap);
-    if (mem == NULL) {
-        fprintf(stderr, "out of memory\n");
-        return -1;
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    options.err_log = print_parse_error;
+
+    void *mem = NULL;
+    lsml_data_t *data;
+    if (seekable) {
+        // measure the memory needed by parsing every file, then read them again
+        size_t mem_cap = 0;
+        files_reader_t all = {files, n_files, 0, 0, {0}};
+        lsml_reader_t reader = {NULL, &all, files_reader_read};
+        if (n_files > 0) all.reader = lsml_reader_from_stream(files[0]);
+        lsml_err_t err = lsml_parse_measure(reader, options, &mem_cap);
+        if (err) {
+            fprintf(stderr, "LSML error: %s\n", lsml_strerr(err));
+            return err;
+        }
+        for (int i = 0; i < n_files; i++) {
+            rewind(files[i]);
+        }
+        mem = malloc(mem_cap);
+        if (mem == NULL) {
+            fprintf(stderr, "out of memory\n");
+            return -1;
+        }
+        data = lsml_data_new(mem, mem_cap);
+    } else {
+        // input which can't be read twice is parsed into memory that grows as needed
+        lsml_allocator_t allocator = {0};
+        data = lsml_data_new_growable(allocator, 64*1024);
     }
-    
-    lsml_data_t *data = lsml_data_new(mem, mem_cap);
     if (data == NULL) {
         fprintf(stderr, "out of memory\n");
         return -1;
     }
 
-    lsml_parse_options_t options = LSML_PARSE_ALL;
-    options.err_log = print_parse_error;
     for (int i = 0; i < n_files; i++) {
-        file = files[i];
-        lsml_reader_t reader = lsml_reader_from_stream(files[i]);
-        lsml_err_t err = lsml_parse(data, reader, options);
+        lsml_err_t err = lsml_parse(data, lsml_reader_from_stream(files[i]), options);
         if (err) {
             fprintf(stderr, "LSML error: %s\n", lsml_strerr(err));
             return err;
         }
-        if (file != stdin) fclose(file);
+        if (files[i] != stdin) fclose(files[i]);
     }
 
     lsml_writer_t writer = lsml_writer_to_stream(stdout);
@@ -116,7 +128,8 @@ int main(int argc, const char **argv) {
         return err;
     }
 
-    free(mem);
+    if (mem) free(mem);
+    else lsml_data_free(data);
     if (files != &file) free(files);
 
     return 0;
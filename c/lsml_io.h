@@ -44,10 +44,12 @@ typedef struct lsml_writer_t {
 } lsml_writer_t;
 
 // Wraps a buffer into a lsml_reader_t.
+// The rest of the buffer is lent to the parser as a single block.
 lsml_reader_t lsml_reader_from_buffer(lsml_const_buffer_t *buffer);
 
 // Wraps a stdio FILE* into a lsml_reader_t.
 // The file must be open for reading!
+// The stream is read in blocks with fread, so the reader may read past the end of the parsed data.
 lsml_reader_t lsml_reader_from_stream(FILE *stream);
 
 // Wraps a buffer into a lsml_writer_t.
@@ -62,7 +64,7 @@ lsml_writer_t lsml_writer_to_stream(FILE *stream);
 
 
 // Writes a section, including its header and contents.
-// - Table keys may be out of order
+// - Table keys will be in the order they were added
 // - Array values will be in the same order, including the structure of rows and columns.
 // - If ascii is true, then any valid utf8 characters are converted to codepoint escapes in quoted strings.
 // Returns ERR_VALUE_NULL if the writer's write function is NULL.
@@ -71,8 +73,7 @@ lsml_writer_t lsml_writer_to_stream(FILE *stream);
 lsml_err_t lsml_write_section(lsml_writer_t writer, const lsml_section_t *section, int no_header, int no_contents);
 
 // Writes the contents of data to the writer in valid LSML syntax.
-// - Sections may be out of order
-// - Table keys may be out of order
+// - Sections and table keys will be in the order they were added, so parsed text keeps its order
 // - Array values will be in the same order, including the structure of rows and columns.
 // - If ascii is true, then any valid utf8 characters are converted to codepoint escapes in quoted strings.
 // Returns ERR_VALUE_NULL if the writer's write function is NULL.
@@ -80,6 +81,14 @@ lsml_err_t lsml_write_section(lsml_writer_t writer, const lsml_section_t *sectio
 // Returns ERR_OUT_OF_MEMORY if the write was incomplete.
 lsml_err_t lsml_write_data(lsml_writer_t writer, const lsml_data_t *data);
 
+// Saves a snapshot of a frozen data to the writer, which lsml_data_open_snapshot opens without parsing.
+// The snapshot is a header (see lsml_data_snapshot_header), followed by the data's whole buffer.
+// The data holds no pointers, so it may be frozen anywhere, and the snapshot loaded or mapped anywhere.
+// Returns ERR_VALUE_NULL if the writer's write function is NULL.
+// Returns INVALID_DATA if the data is NULL or not frozen.
+// Returns ERR_OUT_OF_MEMORY if the write was incomplete.
+lsml_err_t lsml_data_save_snapshot(const lsml_data_t *data, lsml_writer_t writer);
+
 
 #ifdef __cplusplus
 }
@@ -103,8 +112,20 @@ static int lsml_reader_from_buffer_getc(void *userdata) {
     return c;
 }
 
+// Lends the rest of the buffer as one block.
+static size_t lsml_reader_from_buffer_read(void *userdata, char *buf, size_t buf_size, const char **block) {
+    lsml_const_buffer_t *buffer = (lsml_const_buffer_t *) userdata;
+    (void) buf;
+    (void) buf_size;
+    if (buffer == NULL || buffer->ptr == NULL || buffer->index >= buffer->capacity) return 0;
+    size_t len = buffer->capacity - buffer->index;
+    *block = (const char *)buffer->ptr + buffer->index;
+    buffer->index = buffer->capacity;
+    return len;
+}
+
 lsml_reader_t lsml_reader_from_buffer(lsml_const_buffer_t *buffer) {
-    lsml_reader_t reader = {lsml_reader_from_buffer_getc, buffer};
+    lsml_reader_t reader = {lsml_reader_from_buffer_getc, buffer, lsml_reader_from_buffer_read};
     return reader;
 }
 
@@ -113,8 +134,15 @@ static int lsml_reader_from_stream_getc(void *userdata) {
     return fgetc(file);
 }
 
+// Fills the parser's buffer with as many bytes as the stream can give.
+static size_t lsml_reader_from_stream_read(void *userdata, char *buf, size_t buf_size, const char **block) {
+    FILE *file = (FILE*) userdata;
+    *block = buf;
+    return fread(buf, 1, buf_size, file);
+}
+
 lsml_reader_t lsml_reader_from_stream(FILE *stream) {
-    lsml_reader_t reader = {lsml_reader_from_stream_getc, stream};
+    lsml_reader_t reader = {lsml_reader_from_stream_getc, stream, lsml_reader_from_stream_read};
     return reader;
 }
 
@@ -357,6 +385,23 @@ lsml_err_t lsml_write_data(lsml_writer_t writer, const lsml_data_t *data) {
     return LSML_OK;
 }
 
+lsml_err_t lsml_data_save_snapshot(const lsml_data_t *data, lsml_writer_t writer) {
+    unsigned char header[LSML_SNAPSHOT_HEADER_SIZE];
+    size_t image_size;
+    if (writer.write == NULL) return LSML_ERR_VALUE_NULL;
+    lsml_err_t err = lsml_data_snapshot_header(data, header);
+    if (err) return err;
+    // a frozen data never changes, so reading its buffer leaves it as it was
+    const unsigned char *image = (const unsigned char *) lsml_data_buffer((lsml_data_t *) data, &image_size);
+    for (size_t i = 0; i < LSML_SNAPSHOT_HEADER_SIZE; i++) {
+        if (lsml_putc(writer, header[i])) return LSML_ERR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < image_size; i++) {
+        if (lsml_putc(writer, image[i])) return LSML_ERR_OUT_OF_MEMORY;
+    }
+    return LSML_OK;
+}
+
 #ifdef __cplusplus
 }
 #endif
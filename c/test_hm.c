@@ -84,6 +84,97 @@ int main() {
     LSML_ASSERT(table == found); // Verify that pointer was not modified
     
     print_data(data);
-    
+
+    // seeds can only be set while the data is empty, and hashes depend on the seed
+    LSML_ASSERT(LSML_ERR_INVALID_DATA == lsml_data_set_seed(data, 1));
+    {
+        char seeded_buf[4096];
+        const char *long_key = "a key which is long enough to be hashed 48 bytes at a time, twice over, and then some";
+        lsml_data_t *seeded = lsml_data_new(seeded_buf, sizeof(seeded_buf));
+        lsml_reg_str_t *s_long, *s_long2;
+        LSML_ASSERT(seeded);
+        LSML_TRY(lsml_data_set_seed(seeded, 1));
+        LSML_TRY(lsml_data_register_string(seeded, long_key, 0, 0, &s_long));
+        LSML_TRY(lsml_data_register_string(seeded, long_key, 0, 0, &s_long2));
+        LSML_ASSERT(s_long == s_long2);
+        LSML_ASSERT(s_long->hash == lsml_hash_string(&s_long->string, 1));
+        LSML_ASSERT(s_long->hash != lsml_hash_string(&s_long->string, 2));
+        LSML_TRY(lsml_data_add_section_internal(seeded, s_long, LSML_TABLE, &table));
+        LSML_TRY(lsml_data_get_section(seeded, LSML_TABLE, long_key, 0, &found, NULL));
+        LSML_ASSERT(table == found);
+    }
+
+    // tables and the strings pool keep every entry as they grow through several capacities
+    {
+        size_t grow_size = 1024*1024;
+        char *grow_buf = (char *) malloc(grow_size);
+        lsml_data_t *grown = lsml_data_new(grow_buf, grow_size);
+        lsml_section_t *big;
+        lsml_iter_t iter = {0};
+        lsml_string_t key, value;
+        char keybuf[32];
+        size_t n_seen = 0;
+        LSML_ASSERT(grown);
+        LSML_TRY(lsml_data_add_section(grown, LSML_TABLE, "big", 0, &big));
+        for (int i = 0; i < 2000; i++) {
+            int len = snprintf(keybuf, sizeof keybuf, "key%d", i);
+            LSML_TRY(lsml_table_add_entry(grown, big, keybuf, (size_t) len, keybuf + 3, (size_t) len - 3));
+        }
+        LSML_ASSERT(LSML_ERR_TABLE_KEY_REUSED == lsml_table_add_entry(grown, big, "key1999", 0, "", 0));
+        LSML_ASSERT(lsml_section_len(big) == 2000);
+        LSML_ASSERT(big->section.table.cap > 2000);
+        LSML_ASSERT(grown->strings.cap > grown->n_strings);
+        for (int i = 0; i < 2000; i++) {
+            int len = snprintf(keybuf, sizeof keybuf, "key%d", i);
+            LSML_TRY(lsml_table_get(big, keybuf, (size_t) len, &value));
+            LSML_ASSERT(value.len == (size_t) len - 3 && memcmp(value.str, keybuf + 3, value.len) == 0);
+        }
+        LSML_ASSERT(LSML_ERR_NOT_FOUND == lsml_table_get(big, "key2000", 0, &value));
+        // entries are visited in the order they were added, through every capacity
+        while (lsml_table_next(big, &iter, &key, &value)) {
+            snprintf(keybuf, sizeof keybuf, "key%d", (int) n_seen);
+            LSML_ASSERT(strcmp(key.str, keybuf) == 0);
+            LSML_ASSERT(strcmp(key.str + 3, value.str) == 0);
+            n_seen += 1;
+        }
+        LSML_ASSERT(n_seen == 2000);
+        // and so are sections, whatever their names hash to
+        for (int i = 0; i < 200; i++) {
+            int len = snprintf(keybuf, sizeof keybuf, "section%d", 199 - i);
+            LSML_TRY(lsml_data_add_section(grown, LSML_ARRAY, keybuf, (size_t) len, NULL));
+        }
+        lsml_iter_t sections_iter = {0};
+        lsml_section_t *section;
+        lsml_string_t name;
+        LSML_ASSERT(lsml_data_next_section(grown, &sections_iter, &section, NULL) && section == big);
+        for (int i = 0; i < 200; i++) {
+            snprintf(keybuf, sizeof keybuf, "section%d", 199 - i);
+            LSML_ASSERT(lsml_data_next_section(grown, &sections_iter, &section, NULL));
+            LSML_TRY(lsml_section_info(section, &name, NULL, NULL));
+            LSML_ASSERT(strcmp(name.str, keybuf) == 0);
+        }
+        LSML_ASSERT(!lsml_data_next_section(grown, &sections_iter, &section, NULL));
+        LSML_ASSERT(!lsml_data_next_section(grown, &sections_iter, &section, NULL));
+        free(grow_buf);
+    }
+
+    // a minimal perfect hash gives each key its own index, but can't separate keys with the same hash
+    {
+        size_t n_keys = 1000;
+        lsml_hash_t scratch[1000 + 1000/64 + 1]; // the hashes, then a bit for each key
+        uint32_t pilots[1000/LSML_MPH_BUCKET_LEN];
+        unsigned char seen[1000] = {0};
+        lsml_mph_t mph = {pilots, 0};
+        for (size_t i = 0; i < n_keys; i++) scratch[i] = lsml_wymix(i, lsml_wyp[2]);
+        LSML_ASSERT(lsml_mph_build(&mph, scratch, n_keys) == 0);
+        for (size_t i = 0; i < n_keys; i++) {
+            size_t index = lsml_mph_index(&mph, lsml_wymix(i, lsml_wyp[2]), n_keys);
+            LSML_ASSERT(index < n_keys && !seen[index]);
+            seen[index] = 1;
+        }
+        for (size_t i = 0; i < n_keys; i++) scratch[i] = lsml_wymix(i % (n_keys - 1), lsml_wyp[2]);
+        LSML_ASSERT(lsml_mph_build(&mph, scratch, n_keys) != 0);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lsml.h"
 #define LSML_IO_IMPL
 #include "lsml_io.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define TEST_MMAP
+#endif
 
 
 static const char *markup = ""
@@ -32,6 +38,92 @@ static int print_parse_error(void *ud, lsml_err_t errcode, lsml_index_t line_no)
 
 #define MEM_CAP (1048576)
 
+// Writes data to a new buffer, returning its length
+static size_t write_to_buffer(const lsml_data_t *data, char *buf, size_t buf_size) {
+    lsml_buffer_t buffer = {buf, buf_size, 0};
+    if (lsml_write_data(lsml_writer_to_buffer(&buffer), data)) return 0;
+    return buffer.index;
+}
+
+// Saves a snapshot of the frozen data to a file, then loads it into other memory and opens it.
+static int test_snapshot(lsml_data_t *data) {
+    static char expected[4096], written[4096];
+    size_t frozen_size = lsml_data_freeze_size(data);
+    char *frozen_mem = (char *) malloc(frozen_size);
+    lsml_data_t *frozen = frozen_mem ? lsml_data_freeze(data, frozen_mem, frozen_size) : NULL;
+    size_t expected_len = write_to_buffer(data, expected, sizeof expected);
+    FILE *file = tmpfile();
+    if (frozen == NULL || expected_len == 0 || file == NULL) return -1;
+    if (lsml_data_save_snapshot(data, lsml_writer_to_stream(file)) != LSML_ERR_INVALID_DATA) return -1; // not frozen
+    if (lsml_data_save_snapshot(frozen, lsml_writer_to_stream(file))) return -1;
+    long snapshot_len = ftell(file);
+    char *snapshot = (char *) malloc((size_t) snapshot_len);
+    rewind(file);
+    if (snapshot == NULL || fread(snapshot, 1, (size_t) snapshot_len, file) != (size_t) snapshot_len) return -1;
+    fclose(file);
+    free(frozen_mem); // the snapshot doesn't need the original
+    if (lsml_snapshot_verify(snapshot, (size_t) snapshot_len)) return -1;
+    if (lsml_data_open_snapshot(snapshot, (size_t) snapshot_len - 1)) return -1;
+    snapshot[LSML_SNAPSHOT_HEADER_SIZE + 1] ^= 1; // damaged contents are only found by verifying
+    if (lsml_snapshot_verify(snapshot, (size_t) snapshot_len) != LSML_ERR_INVALID_DATA) return -1;
+    snapshot[LSML_SNAPSHOT_HEADER_SIZE + 1] ^= 1;
+    snapshot[8] ^= 1; // a damaged header or another version isn't opened
+    if (lsml_data_open_snapshot(snapshot, (size_t) snapshot_len)) return -1;
+    snapshot[8] ^= 1;
+    lsml_data_t *opened = lsml_data_open_snapshot(snapshot, (size_t) snapshot_len);
+    if (opened == NULL || lsml_data_open_snapshot_readonly(snapshot, (size_t) snapshot_len) != opened) return -1;
+    size_t written_len = write_to_buffer(opened, written, sizeof written);
+    if (written_len != expected_len || memcmp(written, expected, expected_len) != 0) return -1;
+    lsml_string_t value;
+    lsml_section_t *table;
+    if (lsml_data_get_section(opened, LSML_TABLE, "table", 0, &table, NULL) || lsml_table_get(table, "key", 0, &value)) return -1;
+    if (strcmp(value.str, "value") != 0) return -1;
+    free(snapshot);
+    return 0;
+}
+
+#ifdef TEST_MMAP
+// Checks that an opened snapshot writes the same text as the data it was saved from.
+static int snapshot_matches(const lsml_data_t *opened, const char *expected, size_t expected_len) {
+    static char written[4096];
+    if (opened == NULL) return 0;
+    size_t written_len = write_to_buffer(opened, written, sizeof written);
+    return written_len == expected_len && memcmp(written, expected, expected_len) == 0;
+}
+
+// Maps a snapshot file into read-only memory twice, and opens both mappings where they are.
+static int test_snapshot_mmap(lsml_data_t *data) {
+    static char expected[4096];
+    unsigned char header[LSML_SNAPSHOT_HEADER_SIZE];
+    size_t frozen_size = lsml_data_freeze_size(data), snapshot_len;
+    size_t expected_len = write_to_buffer(data, expected, sizeof expected);
+    char *frozen_mem = (char *) malloc(frozen_size);
+    lsml_data_t *frozen = frozen_mem ? lsml_data_freeze(data, frozen_mem, frozen_size) : NULL;
+    FILE *file = tmpfile();
+    if (frozen == NULL || expected_len == 0 || file == NULL) return -1;
+    if (lsml_data_save_snapshot(frozen, lsml_writer_to_stream(file)) || fflush(file)) return -1;
+    free(frozen_mem);
+    rewind(file);
+    if (fread(header, 1, sizeof header, file) != sizeof header) return -1;
+    if (lsml_snapshot_info(header, &snapshot_len)) return -1;
+    if (snapshot_len != LSML_SNAPSHOT_HEADER_SIZE + frozen_size) return -1;
+    header[8] ^= 1;
+    if (lsml_snapshot_info(header, NULL) != LSML_ERR_INVALID_DATA) return -1;
+    // the data holds no pointers, so it opens at any address without being written to
+    int fd = fileno(file);
+    char *first = (char *) mmap(NULL, snapshot_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    char *second = (char *) mmap(NULL, snapshot_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (first == MAP_FAILED || second == MAP_FAILED || first == second) return -1;
+    if (!snapshot_matches(lsml_data_open_snapshot_readonly(first, snapshot_len), expected, expected_len)) return -1;
+    if (!snapshot_matches(lsml_data_open_snapshot_readonly(second, snapshot_len), expected, expected_len)) return -1;
+    if (lsml_snapshot_verify(second, snapshot_len)) return -1;
+    munmap(second, snapshot_len);
+    munmap(first, snapshot_len);
+    fclose(file);
+    return 0;
+}
+#endif
+
 int main() {
     lsml_err_t err;
     FILE *file = tmpfile();
@@ -66,5 +158,9 @@ int main() {
         fprintf(stderr, "LSML error: %s\n", lsml_strerr(err));
         return err;
     }
+    if (test_snapshot(data)) return -1;
+#ifdef TEST_MMAP
+    if (test_snapshot_mmap(data)) return -1;
+#endif
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "lsml.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
 #define LSML_TRY(expr) do { lsml_err_t err__ = (expr); if (err__) { lsml_print_line_info("LSML error: %s at %s:%u\n", lsml_strerr(err__), __FILE__, __LINE__); return err__; } } while(0)
@@ -35,4 +36,48 @@ int main() {
     clock_t clock_total = clock() - t_start;
     double duration = clock_total * (1.0 / CLOCKS_PER_SEC);
     fprintf(stderr, "Total time: %fs\n", duration);
+
+    // every element is reached directly, back to front
+    t_start = clock();
+    for (int i = 99999; i >= 1; i--) {
+        char buf[256] = {0};
+        size_t buf_strlen = snprintf(buf, sizeof(buf)-1, "%d", i);
+        lsml_string_t value;
+        LSML_TRY(lsml_array_get(array, (size_t)(i - 1), &value));
+        LSML_ASSERT(value.len == buf_strlen && memcmp(value.str, buf, buf_strlen) == 0);
+        // every value is pushed onto a new row
+        LSML_TRY(lsml_array_get_2d(array, (size_t)(i - 1), 0, &value));
+        LSML_ASSERT(value.len == buf_strlen && memcmp(value.str, buf, buf_strlen) == 0);
+    }
+    clock_total = clock() - t_start;
+    fprintf(stderr, "Random access time: %fs\n", clock_total * (1.0 / CLOCKS_PER_SEC));
+    {
+        lsml_string_t values[3];
+        LSML_TRY(lsml_array_get_many(array, 99996, 3, values));
+        LSML_ASSERT(values[0].len == 5 && memcmp(values[0].str, "99997", 5) == 0);
+        LSML_ASSERT(values[2].len == 5 && memcmp(values[2].str, "99999", 5) == 0);
+        LSML_ASSERT(lsml_array_get_many(array, 99997, 3, values) == LSML_ERR_NOT_FOUND);
+        LSML_ASSERT(lsml_array_get(array, 99999, values) == LSML_ERR_NOT_FOUND);
+        LSML_ASSERT(lsml_array_get_2d(array, 5, 1, values) == LSML_ERR_NOT_FOUND);
+    }
+    {
+        // a page of rows near the end, with a values buffer too small for all of them
+        lsml_array_span_t spans[4];
+        lsml_string_t values[3];
+        size_t n_values;
+        LSML_TRY(lsml_array_get_rows(array, 99995, 4, spans, values, 3, &n_values));
+        LSML_ASSERT(n_values == 4);
+        LSML_ASSERT(spans[0].start == 99995 && spans[0].len == 1 && spans[3].start == 99998);
+        LSML_ASSERT(values[2].len == 5 && memcmp(values[2].str, "99998", 5) == 0);
+        LSML_ASSERT(lsml_array_get_rows(array, 99996, 4, spans, values, 3, &n_values) == LSML_ERR_NOT_FOUND);
+    }
+    {
+        size_t rows, cols;
+        LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+        LSML_ASSERT(rows == 99999 && cols == 1);
+        LSML_TRY(lsml_array_find_2d(array, "99990", 0, &rows, &cols));
+        LSML_ASSERT(rows == 99989 && cols == 0);
+    }
+    free(scratch);
+    return 0;
 }
\ No newline at end of file
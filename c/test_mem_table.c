@@ -14,7 +14,54 @@ static void print_mem_usage(lsml_data_t *data, const char *event) {
     printf("%llu bytes used after %s\n", mem, event);
 }
 
-#define MEM_CAP (16*1024*1024)
+#define MEM_CAP (32*1024*1024)
+#define N_KEYS 100000
+#define N_SECTIONS 10000
+#define N_LOOKUPS 2000000
+
+// Looks up keys and section names in a scrambled order, in the data as built and frozen.
+static int bench_lookups(lsml_data_t *data) {
+    char *frozen_mem = (char *) malloc(MEM_CAP);
+    char (*keys)[16] = (char (*)[16]) malloc(N_LOOKUPS*16);
+    char (*names)[16] = (char (*)[16]) malloc(N_LOOKUPS*16);
+    LSML_ASSERT(frozen_mem && keys && names);
+    for (int i = 0; i < N_SECTIONS; i++) {
+        char buf[16];
+        size_t buf_strlen = snprintf(buf, sizeof(buf), "section %d", i);
+        LSML_TRY(lsml_data_add_section(data, LSML_TABLE, buf, buf_strlen, NULL));
+    }
+    for (unsigned long i = 0; i < N_LOOKUPS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "%lu", 1 + (i*7919) % (N_KEYS-1));
+        snprintf(names[i], sizeof(names[i]), "section %lu", (i*7919) % N_SECTIONS);
+    }
+    size_t frozen_size = lsml_data_freeze_size(data);
+    LSML_ASSERT(frozen_size <= MEM_CAP);
+    lsml_data_t *frozen = lsml_data_freeze(data, frozen_mem, frozen_size);
+    LSML_ASSERT(frozen);
+    fprintf(stderr, "Frozen from %llu to %llu bytes\n", (unsigned long long) lsml_data_mem_usage(data), (unsigned long long) frozen_size);
+    lsml_data_t *datas[2] = {data, frozen};
+    const char *kinds[2] = {"Hashmap", "Frozen"};
+    for (int d = 0; d < 2; d++) {
+        lsml_section_t *section;
+        lsml_string_t value;
+        LSML_TRY(lsml_data_get_section(datas[d], LSML_TABLE, "table", 0, &section, NULL));
+        clock_t t_start = clock();
+        for (int i = 0; i < N_LOOKUPS; i++) {
+            LSML_TRY(lsml_table_get(section, keys[i], 0, &value));
+        }
+        double table_time = (clock() - t_start) * (1.0 / CLOCKS_PER_SEC);
+        t_start = clock();
+        for (int i = 0; i < N_LOOKUPS; i++) {
+            LSML_TRY(lsml_data_get_section(datas[d], LSML_TABLE, names[i], 0, &section, NULL));
+        }
+        double section_time = (clock() - t_start) * (1.0 / CLOCKS_PER_SEC);
+        fprintf(stderr, "%s: %d table lookups in %fs, %d section lookups in %fs\n", kinds[d], N_LOOKUPS, table_time, N_LOOKUPS, section_time);
+    }
+    free(frozen_mem);
+    free(keys);
+    free(names);
+    return 0;
+}
 
 int main() {
     char *scratch = (char *) malloc(MEM_CAP);
@@ -26,7 +73,7 @@ int main() {
     lsml_section_t *table;
     LSML_TRY(lsml_data_add_section(data, LSML_TABLE, "table", 0, &table));
     clock_t t_start = clock();
-    for (int i = 1; i < 100000; i++) {
+    for (int i = 1; i < N_KEYS; i++) {
         char buf[256] = {0};
         size_t buf_strlen = snprintf(buf, sizeof(buf)-1, "%d", i);
         LSML_TRY(lsml_table_add_entry(data, table, buf, buf_strlen, buf, buf_strlen));
@@ -35,4 +82,7 @@ int main() {
     clock_t clock_total = clock() - t_start;
     double duration = clock_total * (1.0 / CLOCKS_PER_SEC);
     fprintf(stderr, "Total time: %fs\n", duration);
+    int err = bench_lookups(data);
+    free(scratch);
+    return err;
 }
\ No newline at end of file
@@ -0,0 +1,963 @@
+#include "lsml.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LSML_TRY(expr) do { lsml_err_t err__ = (expr); if (err__) { lsml_print_line_info("LSML error: %s at %s:%u\n", lsml_strerr(err__), __FILE__, __LINE__); return err__; } } while(0)
+#define LSML_ASSERT(expr) do { if(!(expr)) { lsml_print_line_info("LSML assertion failed: %s at %s:%u\n", #expr, __FILE__, __LINE__); return -1; } } while(0)
+static void lsml_print_line_info(const char *fmt, const char *expr, const char *file, unsigned int line) {
+    fprintf(stderr, fmt, expr, file, line);
+}
+
+static const char *markup = ""
+"{table} # comment1\n"
+"key=value # comment2\n"
+"empty value= # comment3\n"
+"=empty key\n"
+"missing_equals\n"
+"\"quoted key\" = 'quoted value'\n"
+"# line comment\n"
+"\n"
+"[array] text after section on line 9\n"
+"{}reference\n"
+"{}`escaped\\tref \\U0001F171`\n"
+"1, `\\062` \n"
+"`\\x33`,4,0.51e1,`\\x`# comment\n"
+",,{},🅰🅱CDEF\n"
+"\n"
+"{  } # empty section name\n"
+"if you're seeing this = something went wrong\n"
+"[last]\n"
+"no newline at end"
+;
+
+#define MEM_CAP (1048576)
+
+typedef struct err_log_t {
+    lsml_err_t errs[64];
+    lsml_index_t lines[64];
+    size_t n;
+} err_log_t;
+
+static int log_err(void *userdata, lsml_err_t errcode, lsml_index_t line_no) {
+    err_log_t *log = (err_log_t *) userdata;
+    if (log->n < 64) {
+        log->errs[log->n] = errcode;
+        log->lines[log->n] = line_no;
+    }
+    log->n += 1;
+    return 0;
+}
+
+// Checks that both datas have the same sections and contents.
+// Sections and table entries must also be iterated in the same order.
+static int data_eq(const lsml_data_t *a, const lsml_data_t *b) {
+    lsml_iter_t data_iter = {0}, other_data_iter = {0};
+    lsml_section_t *section, *other, *other_next;
+    lsml_section_type_t section_type;
+    if (lsml_data_section_count(a) != lsml_data_section_count(b)) return 0;
+    while (lsml_data_next_section(a, &data_iter, &section, &section_type)) {
+        lsml_iter_t section_iter = {0}, other_iter = {0};
+        lsml_string_t name, key, value, other_key, other_value;
+        lsml_section_info(section, &name, NULL, NULL);
+        if (lsml_data_get_section(b, section_type, name.str, name.len, &other, NULL)) return 0;
+        if (!lsml_data_next_section(b, &other_data_iter, &other_next, NULL) || other_next != other) return 0;
+        if (lsml_section_len(section) != lsml_section_len(other)) return 0;
+        if (section_type == LSML_TABLE) {
+            while (lsml_table_next(section, &section_iter, &key, &value)) {
+                if (!lsml_table_next(other, &other_iter, &other_key, NULL)) return 0;
+                if (key.len != other_key.len || memcmp(key.str, other_key.str, key.len) != 0) return 0;
+                if (lsml_table_get(other, key.str, key.len, &other_value)) return 0;
+                if (value.len != other_value.len || memcmp(value.str, other_value.str, value.len) != 0) return 0;
+            }
+        } else {
+            size_t row, col;
+            while (lsml_array_next_2d(section, &section_iter, &value, &row, &col)) {
+                if (lsml_array_get_2d(other, row, col, &other_value)) return 0;
+                if (value.len != other_value.len || memcmp(value.str, other_value.str, value.len) != 0) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int err_log_eq(const err_log_t *a, const err_log_t *b) {
+    if (a->n != b->n) return 0;
+    for (size_t i = 0; i < a->n && i < 64; i++) {
+        if (a->errs[i] != b->errs[i] || a->lines[i] != b->lines[i]) return 0;
+    }
+    return 1;
+}
+
+// Parses the markup normally, to compare other parse modes against
+static lsml_data_t *parse_reference(void *mem, err_log_t *log) {
+    lsml_string_t reader_str = lsml_string_init(markup, 0);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    if (data == NULL) return NULL;
+    options.err_log = log_err;
+    options.err_log_userdata = log;
+    if (lsml_parse(data, lsml_reader_from_string(&reader_str), options)) return NULL;
+    return data;
+}
+
+static lsml_err_t test_in_place(const lsml_data_t *reference, const err_log_t *reference_log, void *mem) {
+    size_t len = strlen(markup);
+    char *buf = (char *) malloc(len);
+    err_log_t log = {0};
+    lsml_section_t *section;
+    lsml_string_t value;
+    LSML_ASSERT(buf);
+    memcpy(buf, markup, len);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse_in_place(data, buf, len, options));
+    LSML_ASSERT(data_eq(reference, data));
+    LSML_ASSERT(err_log_eq(reference_log, &log));
+    // plain strings are referenced from the buffer, escaped strings are not
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "table", 0, &section, NULL));
+    LSML_TRY(lsml_table_get(section, "quoted key", 0, &value));
+    LSML_ASSERT(value.str >= buf && value.str < buf+len);
+    LSML_ASSERT(value.str[value.len] == 0);
+    LSML_TRY(lsml_data_get_section(data, LSML_ARRAY, "array", 0, &section, NULL));
+    LSML_TRY(lsml_array_get(section, 0, &value));
+    LSML_ASSERT(strcmp(value.str, "{}reference") == 0 && value.str >= buf && value.str < buf+len);
+    LSML_TRY(lsml_array_get(section, 1, &value));
+    LSML_ASSERT(!(value.str >= buf && value.str < buf+len));
+    // the last string has no room for a null terminator, so it is copied
+    LSML_TRY(lsml_data_get_section(data, LSML_ARRAY, "last", 0, &section, NULL));
+    LSML_TRY(lsml_array_get(section, 0, &value));
+    LSML_ASSERT(strcmp(value.str, "no newline at end") == 0);
+    LSML_ASSERT(!(value.str >= buf && value.str < buf+len));
+    printf("In-place parse used %llu bytes\n", (unsigned long long) lsml_data_mem_usage(data));
+    free(buf);
+    return LSML_OK;
+}
+
+// Feeds the markup to a push parser in pieces of every size up to 32 bytes.
+static lsml_err_t test_push(const lsml_data_t *reference, const err_log_t *reference_log, void *mem) {
+    size_t len = strlen(markup);
+    char parser_mem[8192];
+    LSML_ASSERT(lsml_parser_mem_size(64) <= sizeof parser_mem);
+    for (size_t piece_len = 1; piece_len <= 32; piece_len++) {
+        err_log_t log = {0};
+        lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+        LSML_ASSERT(data);
+        lsml_parse_options_t options = LSML_PARSE_ALL;
+        options.err_log = log_err;
+        options.err_log_userdata = &log;
+        lsml_parser_t *parser = lsml_parser_new(parser_mem, lsml_parser_mem_size(64), data, options);
+        LSML_ASSERT(parser);
+        for (size_t i = 0; i < len; i += piece_len) {
+            LSML_TRY(lsml_parser_feed(parser, markup + i, (len - i < piece_len) ? len - i : piece_len));
+        }
+        LSML_TRY(lsml_parser_finish(parser));
+        LSML_ASSERT(data_eq(reference, data));
+        LSML_ASSERT(err_log_eq(reference_log, &log));
+    }
+    // a line split between feeds must fit in the parser's memory
+    {
+        lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+        lsml_parser_t *parser = lsml_parser_new(parser_mem, lsml_parser_mem_size(4), data, LSML_PARSE_ALL);
+        LSML_ASSERT(parser);
+        LSML_TRY(lsml_parser_feed(parser, "{t}\nab", 6));
+        LSML_ASSERT(lsml_parser_feed(parser, "cdefghijklmnopqrstuvwxyz", 24) == LSML_ERR_OUT_OF_MEMORY);
+        LSML_ASSERT(lsml_parser_finish(parser) == LSML_ERR_OUT_OF_MEMORY);
+    }
+    return LSML_OK;
+}
+
+// Checks that both logs have the same errors, in any order
+static int err_log_same_errors(const err_log_t *a, const err_log_t *b) {
+    if (a->n != b->n) return 0;
+    for (size_t i = 0; i < a->n && i < 64; i++) {
+        size_t j = 0;
+        while (j < b->n && j < 64 && (a->errs[i] != b->errs[j] || a->lines[i] != b->lines[j])) j++;
+        if (j >= b->n || j >= 64) return 0;
+    }
+    return 1;
+}
+
+static lsml_err_t test_lazy(const lsml_data_t *reference, const err_log_t *reference_log, void *mem) {
+    err_log_t log = {0};
+    lsml_section_t *section;
+    lsml_string_t value;
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse_lazy(data, markup, strlen(markup), options));
+    LSML_ASSERT(lsml_data_section_count(data) == lsml_data_section_count(reference));
+    // only errors in the header lines are logged so far
+    LSML_ASSERT(log.n == 2);
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "table", 0, &section, NULL));
+    LSML_TRY(lsml_table_get(section, "key", 0, &value));
+    LSML_ASSERT(strcmp(value.str, "value") == 0);
+    LSML_ASSERT(log.n == 3);
+    LSML_ASSERT(data_eq(data, reference));
+    LSML_ASSERT(err_log_same_errors(reference_log, &log));
+    return LSML_OK;
+}
+
+// Measures the markup, and parses it into exactly as much memory as measured.
+static lsml_err_t test_measure(const lsml_data_t *reference, const err_log_t *reference_log, void *mem) {
+    lsml_string_t str = lsml_string_init(markup, 0);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    err_log_t log = {0};
+    size_t bytes_needed = 0;
+    LSML_TRY(lsml_parse_measure(lsml_reader_from_string(&str), options, &bytes_needed));
+    printf("Measured %llu bytes\n", (unsigned long long) bytes_needed);
+    LSML_ASSERT(bytes_needed >= lsml_data_mem_usage(reference));
+    LSML_ASSERT(bytes_needed <= MEM_CAP);
+    lsml_data_t *data = lsml_data_new(mem, bytes_needed);
+    LSML_ASSERT(data);
+    str = lsml_string_init(markup, 0);
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), options));
+    LSML_ASSERT(data_eq(reference, data));
+    LSML_ASSERT(err_log_eq(reference_log, &log));
+    return LSML_OK;
+}
+
+// Freezes the markup parsed normally and lazily, into exactly as much memory as needed.
+static lsml_err_t test_freeze(const lsml_data_t *reference, void *mem) {
+    char *frozen_mem = (char *) malloc(MEM_CAP);
+    lsml_data_t *lazy = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(frozen_mem && lazy);
+    LSML_TRY(lsml_parse_lazy(lazy, markup, strlen(markup), LSML_PARSE_ALL));
+    size_t size = lsml_data_freeze_size(reference);
+    printf("Frozen data needs %llu bytes\n", (unsigned long long) size);
+    LSML_ASSERT(size == lsml_data_freeze_size(lazy));
+    LSML_ASSERT(lsml_data_freeze(reference, frozen_mem, size - 1) == NULL);
+    lsml_data_t *frozen = lsml_data_freeze(lazy, frozen_mem, size);
+    LSML_ASSERT(frozen);
+    LSML_ASSERT(lsml_data_mem_usage(frozen) == size - 1);
+    LSML_ASSERT(data_eq(reference, frozen) && data_eq(frozen, reference));
+    LSML_ASSERT(lsml_data_freeze_size(frozen) == 0);
+    // a frozen data can't be changed until it is cleared
+    LSML_ASSERT(lsml_data_add_section(frozen, LSML_TABLE, "new", 0, NULL) == LSML_ERR_INVALID_DATA);
+    lsml_string_t str = lsml_string_init(markup, 0);
+    LSML_ASSERT(lsml_parse(frozen, lsml_reader_from_string(&str), LSML_PARSE_ALL) == LSML_ERR_INVALID_DATA);
+    // a copy of a frozen data's memory is usable where it is, even after the original is gone
+    char *moved_mem = (char *) calloc(size, 1);
+    LSML_ASSERT(moved_mem);
+    memcpy(moved_mem, frozen_mem, size);
+    memset(frozen_mem, 0xff, size);
+    LSML_ASSERT(lsml_data_relocate(moved_mem, size - 1) == NULL);
+    lsml_data_t *moved = lsml_data_relocate(moved_mem, size);
+    LSML_ASSERT(moved == (lsml_data_t *) moved_mem);
+    LSML_ASSERT(data_eq(reference, moved) && data_eq(moved, reference));
+    // nothing in it depends on where it is, so freezing the same data anywhere gives the same bytes
+    memset(frozen_mem, 0, size);
+    memset(moved_mem, 0, size);
+    LSML_ASSERT(lsml_data_freeze(reference, frozen_mem, size) && lsml_data_freeze(reference, moved_mem, size));
+    LSML_ASSERT(memcmp(frozen_mem, moved_mem, size) == 0);
+    free(moved_mem);
+    frozen = lsml_data_freeze(reference, frozen_mem, MEM_CAP);
+    LSML_ASSERT(frozen);
+    lsml_data_clear(frozen);
+    LSML_ASSERT(lsml_data_section_count(frozen) == 0);
+    LSML_TRY(lsml_data_add_section(frozen, LSML_TABLE, "new", 0, NULL));
+    free(frozen_mem);
+    return LSML_OK;
+}
+
+// Parses the markup with array values stored on their own, which reads the same but uses less memory.
+static lsml_err_t test_uninterned(const lsml_data_t *reference, const err_log_t *reference_log, void *mem) {
+    lsml_string_t str = lsml_string_init(markup, 0);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    err_log_t log = {0};
+    lsml_section_t *array;
+    size_t bytes_needed, n_interned, n_reused;
+    options.intern_arrays = lsml_parse_intern_none;
+    LSML_TRY(lsml_parse_measure(lsml_reader_from_string(&str), options, &bytes_needed));
+    lsml_data_t *data = lsml_data_new(mem, bytes_needed);
+    LSML_ASSERT(data);
+    str = lsml_string_init(markup, 0);
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), options));
+    printf("Uninterned parse used %llu bytes, measured %llu\n", (unsigned long long) lsml_data_mem_usage(data), (unsigned long long) bytes_needed);
+    LSML_ASSERT(lsml_data_mem_usage(data) < lsml_data_mem_usage(reference));
+    LSML_ASSERT(data_eq(reference, data) && data_eq(data, reference));
+    LSML_ASSERT(err_log_eq(reference_log, &log));
+    // only interned values are counted
+    LSML_TRY(lsml_data_get_section(reference, LSML_ARRAY, "array", 0, &array, NULL));
+    LSML_TRY(lsml_array_intern_stats(array, &n_interned, &n_reused));
+    LSML_ASSERT(n_interned == lsml_section_len(array) && n_reused > 0);
+    LSML_TRY(lsml_data_get_section(data, LSML_ARRAY, "array", 0, &array, NULL));
+    LSML_TRY(lsml_array_intern_stats(array, &n_interned, &n_reused));
+    LSML_ASSERT(n_interned == 0 && n_reused == 0);
+    LSML_ASSERT(lsml_array_set_interning(array, 1) == LSML_ERR_INVALID_SECTION);
+    // frozen arrays keep their values
+    {
+        char *frozen_mem = (char *) malloc(MEM_CAP);
+        size_t size = lsml_data_freeze_size(data);
+        LSML_ASSERT(frozen_mem);
+        lsml_data_t *frozen = lsml_data_freeze(data, frozen_mem, size);
+        LSML_ASSERT(frozen);
+        LSML_ASSERT(lsml_data_mem_usage(frozen) == size - 1);
+        LSML_ASSERT(data_eq(reference, frozen));
+        // values stored on their own move with the data
+        char *moved_mem = (char *) malloc(size);
+        LSML_ASSERT(moved_mem);
+        memcpy(moved_mem, frozen_mem, size);
+        free(frozen_mem);
+        frozen = lsml_data_relocate(moved_mem, size);
+        LSML_ASSERT(frozen && data_eq(reference, frozen));
+        free(moved_mem);
+    }
+    // lazily
+    data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    options.err_log = NULL;
+    LSML_TRY(lsml_parse_lazy(data, markup, strlen(markup), options));
+    LSML_ASSERT(data_eq(reference, data));
+    // pushed values
+    LSML_TRY(lsml_data_add_section(data, LSML_ARRAY, "pushed", 0, &array));
+    LSML_TRY(lsml_array_push(data, array, "x", 0, 1));
+    LSML_TRY(lsml_array_push(data, array, "x", 0, 0));
+    LSML_TRY(lsml_array_intern_stats(array, &n_interned, &n_reused));
+    LSML_ASSERT(n_interned == 2 && n_reused == 1);
+    LSML_TRY(lsml_data_add_section(data, LSML_ARRAY, "pushed on their own", 0, &array));
+    LSML_TRY(lsml_array_set_interning(array, 0));
+    LSML_TRY(lsml_array_push(data, array, "x", 0, 1));
+    LSML_TRY(lsml_array_push(data, array, "y", 0, 0));
+    LSML_TRY(lsml_array_intern_stats(array, &n_interned, &n_reused));
+    LSML_ASSERT(n_interned == 0 && n_reused == 0);
+    lsml_string_t value;
+    LSML_TRY(lsml_array_get(array, 1, &value));
+    LSML_ASSERT(strcmp(value.str, "y") == 0);
+    return LSML_OK;
+}
+
+typedef struct counting_allocator_t {
+    size_t n_blocks;
+    size_t max_blocks; // if nonzero, allocating more blocks than this fails
+} counting_allocator_t;
+
+static void *counting_alloc(void *userdata, size_t size) {
+    counting_allocator_t *counter = (counting_allocator_t *) userdata;
+    if (counter->max_blocks && counter->n_blocks >= counter->max_blocks) return NULL;
+    counter->n_blocks += 1;
+    return malloc(size);
+}
+
+static void counting_free(void *userdata, void *ptr, size_t size) {
+    counting_allocator_t *counter = (counting_allocator_t *) userdata;
+    (void) size;
+    counter->n_blocks -= 1;
+    free(ptr);
+}
+
+// Parses the markup into a growable data starting with a tiny block, and frees it.
+static lsml_err_t test_growable(const lsml_data_t *reference, const err_log_t *reference_log) {
+    counting_allocator_t counter = {0};
+    lsml_allocator_t allocator = {counting_alloc, counting_free, &counter};
+    lsml_string_t str = lsml_string_init(markup, 0);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    err_log_t log = {0};
+    lsml_data_t *data = lsml_data_new_growable(allocator, 0);
+    LSML_ASSERT(data);
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), options));
+    printf("Growable parse used %llu bytes in %llu blocks\n", (unsigned long long) lsml_data_mem_usage(data), (unsigned long long) counter.n_blocks);
+    LSML_ASSERT(counter.n_blocks > 1);
+    LSML_ASSERT(data_eq(reference, data));
+    LSML_ASSERT(err_log_eq(reference_log, &log));
+    lsml_data_clear(data);
+    LSML_ASSERT(counter.n_blocks == 1);
+    lsml_data_free(data);
+    LSML_ASSERT(counter.n_blocks == 0);
+    return LSML_OK;
+}
+
+// Gets a table's value as a null-terminated string, or NULL if there is none.
+static const char *table_value(const lsml_data_t *data, const char *table_name, const char *key) {
+    lsml_section_t *table;
+    lsml_string_t value;
+    if (lsml_data_get_section(data, LSML_TABLE, table_name, 0, &table, NULL)) return NULL;
+    if (lsml_table_get(table, key, 0, &value)) return NULL;
+    return value.str;
+}
+
+static const char *defaults_markup = ""
+"{window}\nwidth=800\nheight=600\ntitle=app\n"
+"[fonts]\nmono, sans\n"
+"{keys}\nquit=q\n"
+;
+
+static const char *user_markup = ""
+"{window}\nwidth=1024\nfullscreen=yes\n"
+"[fonts]\nserif\n"
+"[keys]\nq, w\n"
+"{theme}\nname=dark\n"
+;
+
+// Copies datas into others, whole or layered over each other.
+static lsml_err_t test_copy(const lsml_data_t *reference, void *mem) {
+    char *copy_mem = (char *) malloc(MEM_CAP);
+    char *user_mem = (char *) malloc(MEM_CAP);
+    lsml_section_t *section;
+    lsml_section_type_t type;
+    lsml_string_t value;
+    LSML_ASSERT(copy_mem && user_mem);
+    lsml_data_t *copy = lsml_data_new(copy_mem, MEM_CAP);
+    LSML_ASSERT(copy);
+    LSML_TRY(lsml_data_copy(copy, reference, 0));
+    LSML_ASSERT(data_eq(reference, copy) && data_eq(copy, reference));
+    size_t copy_usage = lsml_data_mem_usage(copy);
+    printf("Copy used %llu bytes\n", (unsigned long long) copy_usage);
+    // copying a copy changes nothing, either way
+    LSML_TRY(lsml_data_copy(copy, reference, 0));
+    LSML_TRY(lsml_data_copy(copy, reference, 1));
+    LSML_ASSERT(data_eq(reference, copy));
+    // from lazy and frozen datas
+    lsml_data_t *lazy = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(lazy);
+    LSML_TRY(lsml_parse_lazy(lazy, markup, strlen(markup), LSML_PARSE_ALL));
+    copy = lsml_data_new(copy_mem, MEM_CAP);
+    LSML_TRY(lsml_data_copy(copy, lazy, 0));
+    LSML_ASSERT(data_eq(reference, copy));
+    lsml_data_t *frozen = lsml_data_freeze(reference, mem, MEM_CAP);
+    LSML_ASSERT(frozen);
+    copy = lsml_data_new(copy_mem, MEM_CAP);
+    LSML_TRY(lsml_data_copy(copy, frozen, 0));
+    LSML_ASSERT(data_eq(reference, copy));
+    LSML_ASSERT(lsml_data_copy(frozen, reference, 0) == LSML_ERR_INVALID_DATA);
+    // into barely enough memory, which has no room for the map of strings as well
+    copy = lsml_data_new(copy_mem, copy_usage + 64);
+    LSML_TRY(lsml_data_copy(copy, reference, 0));
+    LSML_ASSERT(data_eq(reference, copy));
+    copy = lsml_data_new(copy_mem, copy_usage / 2);
+    LSML_ASSERT(lsml_data_copy(copy, reference, 0) == LSML_ERR_OUT_OF_MEMORY);
+    // into a growable data, whose map is freed
+    {
+        counting_allocator_t counter = {0};
+        lsml_allocator_t allocator = {counting_alloc, counting_free, &counter};
+        lsml_data_t *growable = lsml_data_new_growable(allocator, 0);
+        LSML_ASSERT(growable);
+        LSML_TRY(lsml_data_copy(growable, reference, 0));
+        LSML_ASSERT(data_eq(reference, growable));
+        lsml_data_free(growable);
+        LSML_ASSERT(counter.n_blocks == 0);
+    }
+    // copying datas with different sections one after another is the same as parsing their text one after another
+    {
+        size_t len = strlen(markup), defaults_len = strlen(defaults_markup);
+        char *text = (char *) malloc(len + defaults_len + 1);
+        LSML_ASSERT(text);
+        memcpy(text, markup, len);
+        text[len] = '\n';
+        memcpy(text + len + 1, defaults_markup, defaults_len);
+        lsml_data_t *concatenated = lsml_data_new(mem, MEM_CAP);
+        LSML_ASSERT(concatenated);
+        LSML_TRY(lsml_parse_in_place(concatenated, text, len + defaults_len + 1, LSML_PARSE_ALL));
+        lsml_data_t *defaults = lsml_data_new(user_mem, MEM_CAP);
+        lsml_string_t str = lsml_string_init(defaults_markup, 0);
+        LSML_TRY(lsml_parse(defaults, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+        copy = lsml_data_new(copy_mem, MEM_CAP);
+        LSML_TRY(lsml_data_copy(copy, reference, 1));
+        LSML_TRY(lsml_data_copy(copy, defaults, 1));
+        LSML_ASSERT(data_eq(concatenated, copy) && data_eq(copy, concatenated));
+        free(text);
+    }
+    // user settings over defaults replace them
+    lsml_data_t *user = lsml_data_new(user_mem, MEM_CAP);
+    LSML_ASSERT(user);
+    lsml_string_t str = lsml_string_init(user_markup, 0);
+    LSML_TRY(lsml_parse(user, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    copy = lsml_data_new(copy_mem, MEM_CAP);
+    str = lsml_string_init(defaults_markup, 0);
+    LSML_TRY(lsml_parse(copy, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    LSML_TRY(lsml_data_copy(copy, user, 1));
+    LSML_ASSERT(lsml_data_section_count(copy) == 4);
+    LSML_ASSERT(strcmp(table_value(copy, "window", "width"), "1024") == 0);
+    LSML_ASSERT(strcmp(table_value(copy, "window", "height"), "600") == 0);
+    LSML_ASSERT(strcmp(table_value(copy, "window", "fullscreen"), "yes") == 0);
+    LSML_TRY(lsml_data_get_section(copy, LSML_ARRAY, "fonts", 0, &section, NULL));
+    LSML_ASSERT(lsml_section_len(section) == 1);
+    LSML_TRY(lsml_data_get_section(copy, LSML_ANYSECTION, "keys", 0, &section, &type));
+    LSML_ASSERT(type == LSML_ARRAY && lsml_section_len(section) == 2);
+    LSML_TRY(lsml_array_get(section, 1, &value));
+    LSML_ASSERT(strcmp(value.str, "w") == 0);
+    // replaced sections and keys keep their place, and new ones come after
+    {
+        const char *keys[4] = {"width", "height", "title", "fullscreen"};
+        const char *names[4] = {"window", "fonts", "keys", "theme"};
+        lsml_iter_t iter = {0};
+        lsml_string_t key, name;
+        LSML_TRY(lsml_data_get_section(copy, LSML_TABLE, "window", 0, &section, NULL));
+        for (int i = 0; i < 4; i++) {
+            LSML_ASSERT(lsml_table_next(section, &iter, &key, NULL) && strcmp(key.str, keys[i]) == 0);
+        }
+        memset(&iter, 0, sizeof iter);
+        for (int i = 0; i < 4; i++) {
+            LSML_ASSERT(lsml_data_next_section(copy, &iter, &section, NULL));
+            LSML_TRY(lsml_section_info(section, &name, NULL, NULL));
+            LSML_ASSERT(strcmp(name.str, names[i]) == 0);
+        }
+    }
+    // defaults under user settings fill in what's missing
+    LSML_TRY(lsml_data_copy(user, copy, 0));
+    copy = lsml_data_new(copy_mem, MEM_CAP);
+    str = lsml_string_init(defaults_markup, 0);
+    LSML_TRY(lsml_parse(copy, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    LSML_TRY(lsml_data_copy(user, copy, 0));
+    LSML_ASSERT(strcmp(table_value(user, "window", "width"), "1024") == 0);
+    LSML_ASSERT(strcmp(table_value(user, "window", "title"), "app") == 0);
+    LSML_TRY(lsml_data_get_section(user, LSML_ANYSECTION, "keys", 0, &section, &type));
+    LSML_ASSERT(type == LSML_ARRAY);
+    LSML_TRY(lsml_data_get_section(user, LSML_ARRAY, "fonts", 0, &section, NULL));
+    LSML_TRY(lsml_array_get(section, 0, &value));
+    LSML_ASSERT(lsml_section_len(section) == 1 && strcmp(value.str, "serif") == 0);
+    free(user_mem);
+    free(copy_mem);
+    return LSML_OK;
+}
+
+// Sets and removes table entries and array values, checking that memory stops growing when the same entries churn.
+static lsml_err_t test_mutate(void *mem) {
+    char *other_mem = (char *) malloc(MEM_CAP);
+    lsml_section_t *table, *array;
+    lsml_string_t key, value;
+    size_t rows, cols;
+    char buf[32];
+    LSML_ASSERT(other_mem);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    lsml_string_t str = lsml_string_init(defaults_markup, 0);
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    // setting keeps an entry's place, and a removed key comes back after the others
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "window", 0, &table, NULL));
+    LSML_TRY(lsml_table_set(data, table, "height", 0, "720", 0));
+    LSML_TRY(lsml_table_set(data, table, "vsync", 0, "on", 0));
+    LSML_TRY(lsml_table_remove(data, table, "width", 0));
+    LSML_ASSERT(lsml_table_remove(data, table, "width", 0) == LSML_ERR_NOT_FOUND);
+    LSML_ASSERT(lsml_table_remove(data, table, "never added", 0) == LSML_ERR_NOT_FOUND);
+    LSML_ASSERT(lsml_table_get(table, "width", 0, NULL) == LSML_ERR_NOT_FOUND);
+    LSML_TRY(lsml_table_add_entry(data, table, "width", 0, "1280", 0));
+    {
+        const char *keys[4] = {"height", "title", "vsync", "width"};
+        const char *values[4] = {"720", "app", "on", "1280"};
+        lsml_iter_t iter = {0};
+        for (int i = 0; i < 4; i++) {
+            LSML_ASSERT(lsml_table_next(table, &iter, &key, &value));
+            LSML_ASSERT(strcmp(key.str, keys[i]) == 0 && strcmp(value.str, values[i]) == 0);
+        }
+        LSML_ASSERT(!lsml_table_next(table, &iter, &key, &value));
+        LSML_ASSERT(lsml_section_len(table) == 4);
+    }
+    // removing and adding the same keys over and over reuses the memory of rebuilt tables
+    size_t usage = 0;
+    for (int i = 0; i < 100; i++) {
+        int len = snprintf(buf, sizeof buf, "key%d", i);
+        LSML_TRY(lsml_table_set(data, table, buf, (size_t) len, buf + 3, (size_t) len - 3));
+    }
+    for (int round = 0; round < 2000; round++) {
+        for (int i = 0; i < 50; i++) {
+            int len = snprintf(buf, sizeof buf, "key%d", (round*7 + i) % 100);
+            LSML_TRY(lsml_table_remove(data, table, buf, (size_t) len));
+            LSML_TRY(lsml_table_set(data, table, buf, (size_t) len, buf + 3, (size_t) len - 3));
+        }
+        if (round == 100) usage = lsml_data_mem_usage(data);
+    }
+    LSML_ASSERT(lsml_data_mem_usage(data) == usage);
+    LSML_ASSERT(lsml_section_len(table) == 4 + 100);
+    LSML_ASSERT(strcmp(table_value(data, "window", "key42"), "42") == 0);
+    LSML_ASSERT(strcmp(table_value(data, "window", "title"), "app") == 0);
+    // freezing and copying skip removed entries
+    {
+        lsml_data_t *frozen = lsml_data_freeze(data, other_mem, MEM_CAP);
+        LSML_ASSERT(frozen && data_eq(data, frozen));
+        LSML_ASSERT(lsml_table_remove(frozen, table, "title", 0) == LSML_ERR_INVALID_DATA);
+        lsml_data_t *copy = lsml_data_new(other_mem, MEM_CAP);
+        LSML_TRY(lsml_data_copy(copy, data, 0));
+        LSML_ASSERT(data_eq(data, copy) && data_eq(copy, data));
+    }
+    // removing a row moves the rows after it, and keeps the dimensions
+    LSML_ASSERT(lsml_table_remove(data, table, "", 0) == LSML_ERR_NOT_FOUND);
+    LSML_TRY(lsml_data_add_section(data, LSML_ARRAY, "grid", 0, &array));
+    LSML_ASSERT(lsml_table_set(data, array, "key", 0, "value", 0) == LSML_ERR_SECTION_TYPE);
+    LSML_ASSERT(lsml_array_remove_row(data, array, 0) == LSML_ERR_NOT_FOUND);
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 0 && cols == 0);
+    for (int i = 0; i < 1000; i++) {
+        int len = snprintf(buf, sizeof buf, "%d", i);
+        LSML_TRY(lsml_array_push(data, array, buf, (size_t) len, i % 10 == 0 || i == 995));
+    }
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 101 && cols == 5);
+    LSML_TRY(lsml_array_remove_row(data, array, 99));
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 100 && cols == 5);
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 100 && cols == 10);
+    LSML_ASSERT(lsml_array_remove_row(data, array, 100) == LSML_ERR_NOT_FOUND);
+    for (int i = 0; i < 50; i++) LSML_TRY(lsml_array_remove_row(data, array, 0));
+    LSML_ASSERT(lsml_section_len(array) == 495);
+    LSML_TRY(lsml_array_get_2d(array, 0, 3, &value));
+    LSML_ASSERT(strcmp(value.str, "503") == 0);
+    LSML_TRY(lsml_array_get_2d(array, 49, 0, &value));
+    LSML_ASSERT(strcmp(value.str, "995") == 0);
+    // values pushed after removing rows fill the chunks left over
+    for (int i = 0; i < 600; i++) {
+        int len = snprintf(buf, sizeof buf, "%d", 1000 + i);
+        LSML_TRY(lsml_array_push(data, array, buf, (size_t) len, i % 10 == 0));
+    }
+    LSML_ASSERT(lsml_section_len(array) == 1095);
+    {
+        lsml_iter_t iter = {0};
+        size_t n_values = 0, row, col;
+        while (lsml_array_next_2d(array, &iter, &value, &row, &col)) {
+            size_t expected = n_values < 490 ? 500 + n_values : 505 + n_values;
+            LSML_ASSERT((size_t) strtoul(value.str, NULL, 10) == expected);
+            n_values += 1;
+        }
+        LSML_ASSERT(n_values == 1095 && row == 109 && col == 9);
+    }
+    while (lsml_section_len(array)) LSML_TRY(lsml_array_remove_row(data, array, 0));
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 0 && cols == 0);
+    LSML_ASSERT(lsml_array_remove_row(data, array, 0) == LSML_ERR_NOT_FOUND);
+    LSML_TRY(lsml_array_push(data, array, "again", 0, 1));
+    LSML_TRY(lsml_array_get(array, 0, &value));
+    LSML_ASSERT(strcmp(value.str, "again") == 0 && lsml_section_len(array) == 1);
+    // removing the narrowest or widest rows finds the next narrowest or widest
+    for (int i = 1; i < 40; i++) LSML_TRY(lsml_array_push(data, array, "x", 0, i == 1 || i == 4 || i == 10 || i == 19 || i == 25 || i == 37));
+    // rows of 1, 3, 6, 9, 6, 12 and 3 values
+    LSML_TRY(lsml_array_remove_row(data, array, 3));
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 6 && cols == 12);
+    LSML_TRY(lsml_array_remove_row(data, array, 4));
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 5 && cols == 6);
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 5 && cols == 1);
+    LSML_TRY(lsml_array_remove_row(data, array, 0));
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 4 && cols == 3);
+    LSML_TRY(lsml_array_remove_row(data, array, 3));
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 3);
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 6);
+    // rows pushed after removing are counted too
+    for (int i = 0; i < 20; i++) LSML_TRY(lsml_array_push(data, array, "y", 0, i == 0));
+    LSML_TRY(lsml_array_push(data, array, "z", 0, 1));
+    LSML_TRY(lsml_array_remove_row(data, array, 0));
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 4 && cols == 20);
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 4 && cols == 1);
+    LSML_TRY(lsml_array_remove_row(data, array, 2));
+    LSML_TRY(lsml_array_2d_size(array, 0, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 1);
+    LSML_TRY(lsml_array_2d_size(array, 1, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 6);
+    // an array storing its values on their own reuses the memory of replaced values
+    LSML_TRY(lsml_data_add_section(data, LSML_ARRAY, "log", 0, &array));
+    LSML_TRY(lsml_array_set_interning(array, 0));
+    for (int i = 0; i < 16; i++) LSML_TRY(lsml_array_push(data, array, "a line of the log", 0, 1));
+    for (int round = 0; round < 1000; round++) {
+        int len = snprintf(buf, sizeof buf, "line %04d of the log", round);
+        LSML_TRY(lsml_array_set(data, array, (size_t) round % 16, buf, (size_t) len));
+        if (round == 100) usage = lsml_data_mem_usage(data);
+    }
+    LSML_ASSERT(lsml_data_mem_usage(data) == usage);
+    LSML_TRY(lsml_array_get(array, 999 % 16, &value));
+    LSML_ASSERT(strcmp(value.str, "line 0999 of the log") == 0);
+    LSML_ASSERT(lsml_array_set(data, array, 16, "", 0) == LSML_ERR_NOT_FOUND);
+    free(other_mem);
+    return LSML_OK;
+}
+
+// Changes a data until most of its memory is abandoned.
+static lsml_err_t churn(lsml_data_t *data) {
+    lsml_section_t *table, *array;
+    char buf[32];
+    lsml_string_t str = lsml_string_init(defaults_markup, 0);
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "window", 0, &table, NULL));
+    LSML_TRY(lsml_data_add_section(data, LSML_ARRAY, "log", 0, &array));
+    LSML_TRY(lsml_array_set_interning(array, 0));
+    for (int i = 0; i < 500; i++) {
+        int len = snprintf(buf, sizeof buf, "%d", i);
+        LSML_TRY(lsml_table_set(data, table, "width", 0, buf, (size_t) len));
+        LSML_TRY(lsml_table_set(data, table, buf, (size_t) len, "temporary", 0));
+        if (i % 10) LSML_TRY(lsml_table_remove(data, table, buf, (size_t) len));
+        LSML_TRY(lsml_array_push(data, array, buf, (size_t) len, 1));
+        if (i % 3) LSML_TRY(lsml_array_remove_row(data, array, 0));
+    }
+    return LSML_OK;
+}
+
+// Changes a data a little, so compacting it reclaims a little.
+static lsml_err_t churn_lightly(lsml_data_t *data) {
+    lsml_section_t *table;
+    lsml_string_t str = lsml_string_init(defaults_markup, 0);
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "window", 0, &table, NULL));
+    LSML_TRY(lsml_table_set(data, table, "width", 0, "a width which is replaced", 0));
+    LSML_TRY(lsml_table_set(data, table, "width", 0, "1024", 0));
+    return LSML_OK;
+}
+
+// Compacts a changed data in place, in memory of each size around the least with room for its compacted copy,
+// so the copy only just fits, or doesn't.
+static lsml_err_t compact_at_sizes(void *mem, void *compact_mem, lsml_err_t (*change)(lsml_data_t *)) {
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    LSML_TRY(change(data));
+    size_t usage = lsml_data_mem_usage(data), n_compacted = 0;
+    lsml_data_t *compacted = lsml_data_compact(data, compact_mem, MEM_CAP, NULL);
+    LSML_ASSERT(compacted && lsml_data_mem_usage(compacted) < usage);
+    size_t fits = usage + lsml_data_mem_usage(compacted);
+    for (size_t size = fits - 256; size < fits + 256; size++) {
+        data = lsml_data_new(mem, size);
+        LSML_ASSERT(data);
+        LSML_TRY(change(data));
+        lsml_err_t err = lsml_data_compact_in_place(data, NULL);
+        LSML_ASSERT(err == LSML_OK || err == LSML_ERR_OUT_OF_MEMORY);
+        LSML_ASSERT(data_eq(data, compacted) && data_eq(compacted, data));
+        LSML_ASSERT(err == LSML_OK ? lsml_data_mem_usage(data) <= usage : lsml_data_mem_usage(data) == usage);
+        n_compacted += lsml_data_mem_usage(data) < usage;
+    }
+    LSML_ASSERT(n_compacted > 0 && n_compacted < 512);
+    return LSML_OK;
+}
+
+// Compacts a changed data into other memory and into its own.
+static lsml_err_t test_compact(void *mem) {
+    char *compact_mem = (char *) malloc(MEM_CAP);
+    lsml_section_t *array;
+    size_t n_reclaimed, n_reclaimed_in_place;
+    LSML_ASSERT(compact_mem);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    LSML_ASSERT(data);
+    LSML_TRY(churn(data));
+    size_t usage = lsml_data_mem_usage(data);
+    lsml_data_t *compacted = lsml_data_compact(data, compact_mem, MEM_CAP, &n_reclaimed);
+    LSML_ASSERT(compacted && data_eq(data, compacted) && data_eq(compacted, data));
+    LSML_ASSERT(lsml_data_mem_usage(compacted) + n_reclaimed == usage && n_reclaimed > usage / 2);
+    printf("Compacting reclaimed %llu of %llu bytes\n", (unsigned long long) n_reclaimed, (unsigned long long) usage);
+    LSML_ASSERT(strcmp(table_value(compacted, "window", "width"), "499") == 0);
+    // compacting a compacted data changes nothing
+    {
+        char *again_mem = (char *) malloc(MEM_CAP);
+        LSML_ASSERT(again_mem);
+        LSML_ASSERT(lsml_data_compact(data, again_mem, lsml_data_mem_usage(compacted) / 2, NULL) == NULL);
+        lsml_data_t *again = lsml_data_compact(compacted, again_mem, MEM_CAP, &n_reclaimed_in_place);
+        LSML_ASSERT(again && data_eq(compacted, again) && n_reclaimed_in_place == 0);
+        LSML_ASSERT(lsml_data_mem_usage(again) == lsml_data_mem_usage(compacted));
+        free(again_mem);
+    }
+    // in place, the data ends up just like the compacted copy
+    LSML_TRY(lsml_data_compact_in_place(data, &n_reclaimed_in_place));
+    LSML_ASSERT(n_reclaimed_in_place == n_reclaimed && data_eq(data, compacted) && data_eq(compacted, data));
+    LSML_ASSERT(lsml_data_mem_usage(data) == lsml_data_mem_usage(compacted));
+    // and compacting it again in place reclaims nothing, and leaves it as it is
+    LSML_TRY(lsml_data_compact_in_place(data, &n_reclaimed_in_place));
+    LSML_ASSERT(n_reclaimed_in_place == 0 && lsml_data_mem_usage(data) == lsml_data_mem_usage(compacted));
+    LSML_ASSERT(data_eq(data, compacted));
+    LSML_TRY(lsml_data_get_section(data, LSML_ARRAY, "log", 0, &array, NULL));
+    LSML_TRY(lsml_array_push(data, array, "more", 0, 1));
+    // a small data which was only parsed is compacted like into other memory, and only the first time
+    {
+        const char *text = "{t}\na=1\nb=2\n[arr]\n1,2,3\n4,5\n";
+        data = lsml_data_new(mem, MEM_CAP);
+        LSML_ASSERT(data);
+        lsml_string_t str = lsml_string_init(text, 0);
+        LSML_TRY(lsml_parse(data, lsml_reader_from_string(&str), LSML_PARSE_ALL));
+        size_t parsed_usage = lsml_data_mem_usage(data);
+        compacted = lsml_data_compact(data, compact_mem, MEM_CAP, NULL);
+        LSML_ASSERT(compacted);
+        LSML_TRY(lsml_data_compact_in_place(data, &n_reclaimed_in_place));
+        LSML_ASSERT(lsml_data_mem_usage(data) == lsml_data_mem_usage(compacted));
+        LSML_ASSERT(n_reclaimed_in_place == parsed_usage - lsml_data_mem_usage(compacted) && data_eq(data, compacted));
+        for (int i = 0; i < 2; i++) {
+            LSML_TRY(lsml_data_compact_in_place(data, &n_reclaimed_in_place));
+            LSML_ASSERT(n_reclaimed_in_place == 0 && lsml_data_mem_usage(data) == lsml_data_mem_usage(compacted));
+            LSML_ASSERT(data_eq(data, compacted));
+        }
+    }
+    // without room for the compacted copy, the data stays as it was
+    data = lsml_data_new(mem, usage + 256);
+    LSML_ASSERT(data);
+    LSML_TRY(churn(data));
+    compacted = lsml_data_compact(data, compact_mem, MEM_CAP, NULL);
+    LSML_ASSERT(lsml_data_compact_in_place(data, NULL) == LSML_ERR_OUT_OF_MEMORY);
+    LSML_ASSERT(data_eq(data, compacted) && lsml_data_mem_usage(data) == usage);
+    LSML_ASSERT(lsml_data_compact_in_place(lsml_data_freeze(compacted, mem, MEM_CAP), NULL) == LSML_ERR_INVALID_DATA);
+    // with only just enough room for the compacted copy, or not quite, the data is compacted or stays as it was
+    LSML_TRY(compact_at_sizes(mem, compact_mem, churn));
+    LSML_TRY(compact_at_sizes(mem, compact_mem, churn_lightly));
+    // a growable data gives back its blocks
+    {
+        counting_allocator_t counter = {0};
+        lsml_allocator_t allocator = {counting_alloc, counting_free, &counter};
+        lsml_data_t *growable = lsml_data_new_growable(allocator, 0);
+        LSML_ASSERT(growable);
+        LSML_TRY(churn(growable));
+        compacted = lsml_data_compact(growable, compact_mem, MEM_CAP, NULL);
+        LSML_ASSERT(compacted);
+        size_t n_blocks = counter.n_blocks;
+        usage = lsml_data_mem_usage(growable);
+        // if the allocator fails, the data stays as it was
+        lsml_err_t err = LSML_ERR_OUT_OF_MEMORY;
+        for (counter.max_blocks = n_blocks + 1; err; counter.max_blocks++) {
+            err = lsml_data_compact_in_place(growable, &n_reclaimed);
+            LSML_ASSERT(err == LSML_OK || err == LSML_ERR_OUT_OF_MEMORY);
+            LSML_ASSERT(data_eq(growable, compacted) && data_eq(compacted, growable));
+            if (err) LSML_ASSERT(counter.n_blocks == n_blocks && lsml_data_mem_usage(growable) == usage);
+        }
+        counter.max_blocks = 0;
+        LSML_ASSERT(n_reclaimed > 0 && counter.n_blocks < n_blocks);
+        LSML_ASSERT(lsml_data_mem_usage(growable) + n_reclaimed == usage);
+        // the compacted data grows, clears and compacts like any other
+        LSML_TRY(lsml_data_compact_in_place(growable, &n_reclaimed));
+        LSML_ASSERT(n_reclaimed == 0 && data_eq(growable, compacted));
+        LSML_TRY(lsml_data_get_section(growable, LSML_ARRAY, "log", 0, &array, NULL));
+        for (int i = 0; i < 1000; i++) LSML_TRY(lsml_array_push(growable, array, "more", 0, 1));
+        lsml_data_clear(growable);
+        LSML_ASSERT(counter.n_blocks == 1);
+        LSML_TRY(churn(growable));
+        LSML_TRY(lsml_data_compact_in_place(growable, &n_reclaimed));
+        LSML_ASSERT(n_reclaimed > 0 && data_eq(growable, compacted));
+        lsml_data_free(growable);
+        LSML_ASSERT(counter.n_blocks == 0);
+    }
+    free(compact_mem);
+    return LSML_OK;
+}
+
+// A reader with no read_block is read a byte at a time as the parser needs it,
+// so parsing one section leaves the rest of the input unread.
+static lsml_err_t test_byte_reader(void *mem) {
+    lsml_string_t reader_str = lsml_string_init("{first}\na=1\n{second}\nb=2\n", 0);
+    lsml_reader_t reader = lsml_reader_from_string(&reader_str);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    lsml_section_t *section;
+    lsml_string_t value;
+    LSML_ASSERT(data);
+    reader.read_block = NULL;
+    LSML_TRY(lsml_parse(data, reader, LSML_PARSE_ONE));
+    LSML_ASSERT(lsml_data_section_count(data) == 1);
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "first", 0, &section, NULL));
+    LSML_TRY(lsml_table_get(section, "a", 0, &value));
+    LSML_ASSERT(strcmp(value.str, "1") == 0);
+    LSML_ASSERT(reader_str.len >= strlen("}\nb=2\n"));
+    return LSML_OK;
+}
+
+// Array rows ending with a delimiter and whitespace end at the line break, without taking values
+// or section headers from the next line.
+static lsml_err_t test_row_ends(void *mem) {
+    lsml_string_t reader_str = lsml_string_init("[rows]\n1, \n2, 3,\t\r\n4 ,  \n{after}\nkey=value\n", 0);
+    lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+    err_log_t log = {0};
+    lsml_section_t *rows_section, *after;
+    lsml_string_t value;
+    size_t rows, cols;
+    LSML_ASSERT(data);
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    options.err_log = log_err;
+    options.err_log_userdata = &log;
+    LSML_TRY(lsml_parse(data, lsml_reader_from_string(&reader_str), options));
+    LSML_ASSERT(log.n == 0 && lsml_data_section_count(data) == 2);
+    LSML_TRY(lsml_data_get_section(data, LSML_ARRAY, "rows", 0, &rows_section, NULL));
+    LSML_ASSERT(lsml_section_len(rows_section) == 4);
+    LSML_TRY(lsml_array_2d_size(rows_section, 1, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 2);
+    LSML_TRY(lsml_array_2d_size(rows_section, 0, &rows, &cols));
+    LSML_ASSERT(rows == 3 && cols == 1);
+    LSML_TRY(lsml_array_get_2d(rows_section, 1, 1, &value));
+    LSML_ASSERT(strcmp(value.str, "3") == 0);
+    LSML_TRY(lsml_array_get_2d(rows_section, 2, 0, &value));
+    LSML_ASSERT(strcmp(value.str, "4") == 0);
+    LSML_TRY(lsml_data_get_section(data, LSML_TABLE, "after", 0, &after, NULL));
+    LSML_TRY(lsml_table_get(after, "key", 0, &value));
+    LSML_ASSERT(strcmp(value.str, "value") == 0);
+    return LSML_OK;
+}
+
+// Parses text with lsml_parse_parallel using 1 to 8 threads, with and without interning array values,
+// and compares it to parsing it in place.
+static lsml_err_t test_parallel(const char *text, void *ref_mem, void *mem) {
+    size_t len = strlen(text);
+    size_t scratch_size = 4*MEM_CAP;
+    char *ref_buf = (char *) malloc(len);
+    char *buf = (char *) malloc(len);
+    void *scratch = malloc(scratch_size);
+    err_log_t ref_log = {0};
+    lsml_parse_options_t options = LSML_PARSE_ALL;
+    LSML_ASSERT(ref_buf && buf && scratch);
+    memcpy(ref_buf, text, len);
+    lsml_data_t *reference = lsml_data_new(ref_mem, MEM_CAP);
+    LSML_ASSERT(reference);
+    options.err_log = log_err;
+    options.err_log_userdata = &ref_log;
+    LSML_TRY(lsml_parse_in_place(reference, ref_buf, len, options));
+    for (unsigned int n_threads = 1; n_threads <= 16; n_threads++) {
+        err_log_t log = {0};
+        // the second time around, arrays store their values on their own
+        options.intern_arrays = n_threads > 8 ? lsml_parse_intern_none : NULL;
+        memcpy(buf, text, len);
+        lsml_data_t *data = lsml_data_new(mem, MEM_CAP);
+        LSML_ASSERT(data);
+        options.err_log_userdata = &log;
+        LSML_TRY(lsml_parse_parallel(data, buf, len, options, scratch, scratch_size, (n_threads - 1) % 8 + 1));
+        LSML_ASSERT(data_eq(reference, data));
+        LSML_ASSERT(err_log_eq(&ref_log, &log));
+    }
+    free(scratch);
+    free(buf);
+    free(ref_buf);
+    return LSML_OK;
+}
+
+// Sections repeated across the parts parsed by different threads
+static const char *repeated_markup = ""
+"{a}\nx=1\n\n[b]\n1,2,\n3\n"
+"{c}\ny = 2\n{a}\nreused=1\nmissing equals\n"
+"[d]\n'unclosed\n{b}\nz=1\n"
+"{e}\n\"\"=empty key\n"
+"{c}\nmissing equals\n"
+"[f]\nfirst, second\n{a}\n"
+;
+
+int main() {
+    char *ref_mem = (char *) malloc(MEM_CAP);
+    char *mem = (char *) malloc(MEM_CAP);
+    err_log_t reference_log = {0};
+    if (ref_mem == NULL || mem == NULL) {
+        fprintf(stderr, "Failed to allocate scratch memory\n");
+        return -1;
+    }
+    lsml_data_t *reference = parse_reference(ref_mem, &reference_log);
+    LSML_ASSERT(reference);
+    printf("Reference parse used %llu bytes\n", (unsigned long long) lsml_data_mem_usage(reference));
+    LSML_TRY(test_in_place(reference, &reference_log, mem));
+    LSML_TRY(test_push(reference, &reference_log, mem));
+    LSML_TRY(test_lazy(reference, &reference_log, mem));
+    LSML_TRY(test_measure(reference, &reference_log, mem));
+    LSML_TRY(test_growable(reference, &reference_log));
+    LSML_TRY(test_freeze(reference, mem));
+    LSML_TRY(test_uninterned(reference, &reference_log, mem));
+    LSML_TRY(test_copy(reference, mem));
+    LSML_TRY(test_mutate(mem));
+    LSML_TRY(test_compact(mem));
+    LSML_TRY(test_row_ends(mem));
+    LSML_TRY(test_byte_reader(mem));
+    LSML_TRY(test_parallel(markup, ref_mem, mem));
+    LSML_TRY(test_parallel(repeated_markup, ref_mem, mem));
+    free(mem);
+    free(ref_mem);
+    return 0;
+}
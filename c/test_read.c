@@ -68,6 +68,21 @@ static lsml_err_t check_array_lookup(lsml_data_t *data) {
     err = lsml_array_get_2d(section, 3, 2, &value);
     if (err) return err;
     fprintf(stderr, "Array 2D lookup: [3,2]=%s\n", value.str);
+    err = lsml_array_find_2d(section, "4", 0, &rows, &cols);
+    if (err) return err;
+    fprintf(stderr, "Array 2D find: 4 at [%llu,%llu]\n", (unsigned long long) rows, (unsigned long long) cols);
+    err = lsml_array_find_in_col(section, "4", 0, &rows, 1);
+    if (err) return err;
+    if (lsml_array_find_in_row(section, "4", 0, 2, &cols) != LSML_ERR_NOT_FOUND) return LSML_ERR_INVALID_DATA;
+    {
+        lsml_array_span_t spans[2];
+        lsml_string_t values[6];
+        size_t n_values;
+        err = lsml_array_get_rows(section, 2, 2, spans, values, 6, &n_values);
+        if (err) return err;
+        if (n_values != 6 || spans[0].len != 2 || spans[1].start != spans[0].start + 2 || spans[1].len != 4) return LSML_ERR_INVALID_DATA;
+        fprintf(stderr, "Array rows 2-3: %s ... %s\n", values[0].str, values[5].str);
+    }
     return LSML_OK;
 }
 